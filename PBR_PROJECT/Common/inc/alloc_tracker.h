@@ -0,0 +1,73 @@
+#ifndef __ALLOC_TRACKER_H
+#define __ALLOC_TRACKER_H
+
+#include "custom_macro.h"
+#include "logger.h"
+
+#include <atomic>
+#include <cstddef>
+#include <format>
+#include <string_view>
+
+// Process wide heap accounting. The global operator new/delete in alloc_tracker.cpp only feed these
+// counters when built with TRACK_ALLOCATIONS (cmake -DTRACK_ALLOCATIONS=ON), otherwise all reads are 0.
+class AllocTracker {
+
+	NoConstructor(AllocTracker)
+
+public:
+#ifdef TRACK_ALLOCATIONS
+	static constexpr bool kEnabled = true;
+#else
+	static constexpr bool kEnabled = false;
+#endif
+
+	static std::atomic<size_t> count;		// number of allocations
+	static std::atomic<size_t> bytes;		// bytes requested in total
+	static std::atomic<size_t> current;		// bytes live right now
+	static std::atomic<size_t> peak;		// high water mark of current, see ResetPeak
+
+	static void ResetPeak() { peak = current.load(); }
+
+	// raises peak to at least value
+	static void MergePeak(size_t value) {
+		size_t old = peak;
+		while (old < value && !peak.compare_exchange_weak(old, value)) {}
+	}
+};
+
+// measures the allocations made (by any thread) between construction and Report. The peak is tracked
+// globally: a scope restarts it and merges the one it replaced back when it ends, so nested scopes are
+// fine and an outer scope reads its whole peak once the inner ones are gone. Scopes overlapping without
+// nesting (an async load next to another load) still see each other's peaks
+class AllocScope {
+public:
+	AllocScope()
+		: count_(AllocTracker::count), bytes_(AllocTracker::bytes), current_(AllocTracker::current), outer_peak_(AllocTracker::peak) {
+		AllocTracker::ResetPeak();
+	}
+
+	~AllocScope() { AllocTracker::MergePeak(outer_peak_); }
+
+	AllocScope(const AllocScope&)			 = delete;
+	AllocScope& operator=(const AllocScope&) = delete;
+
+	inline size_t Count() const { return AllocTracker::count - count_; }
+	inline size_t Bytes() const { return AllocTracker::bytes - bytes_; }
+	inline size_t Peak()  const { return AllocTracker::peak - current_; }
+
+	void Report(std::string_view what) const {
+		if constexpr (AllocTracker::kEnabled) {
+			Logger::Message(std::format("allocations during {} - {} allocations, {:.2f} MB requested, peak {:.2f} MB above start",
+				what, Count(), Bytes() / (1024.0 * 1024.0), Peak() / (1024.0 * 1024.0)));
+		}
+	}
+
+private:
+	size_t count_;
+	size_t bytes_;
+	size_t current_;
+	size_t outer_peak_;
+};
+
+#endif // !__ALLOC_TRACKER_H
@@ -3,11 +3,15 @@
 
 #include "model.h"
 #include "bone.h"
+#include "animation_clip.h"
+#include "logger.h"
 
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <format>
 #include <vector>
 #include <string>
 #include <map>
@@ -19,19 +23,32 @@ struct AssimpNodeData {
 	std::vector<AssimpNodeData> children;
 };
 
+// one node of the flattened hierarchy, parents always come before their children
+struct SkeletonNode {
+	int		  parent;		// index into the node array, -1 for the root
+	int		  bone;			// index of the animated track, -1 when the node keeps its bind transform
+	int		  palette;		// slot in the bone matrix palette, -1 when no mesh vertex refers to the node
+	glm::mat4 transform;	// bind transform relative to the parent
+	glm::mat4 offset;		// mesh space to bone space, valid when palette >= 0
+};
+
 class Animation {
 public: 
 	Animation() = default;
 	
-	Animation(const std::string& anim_path, Model* model) {
+	// keys are reduced within compression on load and only kept in the AnimationClip, see GetClip
+	Animation(const std::string& anim_path, Model* model, const ClipCompression& compression = {}) {
 		Assimp::Importer importer;
 		const aiScene* scene = importer.ReadFile(anim_path, aiProcess_Triangulate);
 		assert(scene && scene->mRootNode);
-		auto animation = scene->mAnimations[0];
-		duration_ = animation->mDuration;
-		ticks_per_second_ = animation->mTicksPerSecond;
-		ReadHeirarchyData(root_node_, scene->mRootNode);
-		ReadMissingBone(animation, *model);
+		Load(anim_path, scene, model->GetBoneInfoMap(), model->GetBoneCount(), compression);
+	}
+
+	// the first animation of a scene already in memory. bone_info holds the mesh's bones, bone_count
+	// of them; animated nodes missing from it get the ids after those
+	Animation(const std::string& name, const aiScene* scene, const std::map<std::string, BoneInfo>& bone_info, int bone_count,
+		const ClipCompression& compression = {}) {
+		Load(name, scene, bone_info, bone_count, compression);
 	}
 	
 	~Animation() = default;
@@ -45,6 +62,11 @@ public:
 		return &(*iter);
 	}
 
+	inline Bone& GetBone(int idx)			   { return bones_[idx]; }
+	inline const std::vector<SkeletonNode>& GetNodes() const { return nodes_; }
+	inline const AnimationClip&				GetClip()  const { return clip_; }
+	inline const ClipStats&					GetClipStats() const { return clip_.Stats(); }
+
 	inline float GetTickPerSecond() const      { return ticks_per_second_; }
 	inline float GetDuration()		const      { return duration_; }
 	inline const AssimpNodeData& GetRootNode() { return root_node_; }
@@ -53,22 +75,32 @@ public:
 	}
 
 private:
-	void ReadMissingBone(const aiAnimation* anim, Model& model) {
+	void Load(const std::string& name, const aiScene* scene, const std::map<std::string, BoneInfo>& bone_info, int bone_count,
+		const ClipCompression& compression) {
+		auto animation = scene->mAnimations[0];
+		duration_ = animation->mDuration;
+		ticks_per_second_ = animation->mTicksPerSecond;
+		ReadHeirarchyData(root_node_, scene->mRootNode);
+		ReadMissingBone(animation, bone_info, bone_count);
+		FlattenHierarchy(root_node_, -1);
+		Compress(name, compression);
+	}
+
+	// bones only the animation knows get ids after the model's in a copy of its map, the model itself
+	// is not touched, so this may run on any thread once the model is imported
+	void ReadMissingBone(const aiAnimation* anim, const std::map<std::string, BoneInfo>& bone_info, int bone_count) {
 		int size = anim->mNumChannels;
-		auto& bone_info_map = model.GetBoneInfoMap();
-		int&  bone_count	= model.GetBoneCount();
+		bone_info_map_ = bone_info;
 
 		for (int i = 0; i < size; ++i) {
 			auto channel = anim->mChannels[i];
 			std::string bone_name = channel->mNodeName.data;
-			if (bone_info_map.find(bone_name) == bone_info_map.end()) {
-				bone_info_map[bone_name].id = bone_count;
+			if (bone_info_map_.find(bone_name) == bone_info_map_.end()) {
+				bone_info_map_[bone_name].id = bone_count;
 				bone_count++;
 			}
-			bones_.push_back(Bone(channel->mNodeName.data, bone_info_map[channel->mNodeName.data].id, channel));
+			bones_.push_back(Bone(channel->mNodeName.data, bone_info_map_[bone_name].id, channel));
 		}
-
-		bone_info_map_ = bone_info_map;
 	}
 
 	void ReadHeirarchyData(AssimpNodeData& dest, const aiNode* src) {
@@ -86,6 +118,38 @@ private:
 		}
 	}
 
+	// builds the clip from the bones' keys as imported, which the bones drop afterwards: the bones keep
+	// their names and ids, poses are sampled from the clip
+	void Compress(const std::string& anim_path, const ClipCompression& compression) {
+		clip_ = AnimationClip(bones_, compression);
+		for (Bone& bone : bones_) {
+			bone.ReleaseKeys();
+		}
+		const ClipStats& stats = clip_.Stats();
+		Logger::Message(std::format("animation {} - {} -> {} keys, {:.1f} KB -> {:.1f} KB ({:.1f}x), max error position {:.2e} rotation {:.2e} rad scale {:.2e}",
+			anim_path, stats.raw_keys, stats.keys, stats.raw_bytes / 1024.0, stats.bytes / 1024.0, stats.Ratio(),
+			stats.max_position_error, stats.max_rotation_error, stats.max_scale_error));
+	}
+
+	// pre-order walk, so a node's parent is always evaluated first. The names are resolved here once,
+	// evaluating the pose (Animator::UpdateAnimation) only follows indices
+	void FlattenHierarchy(const AssimpNodeData& src, int parent) {
+		SkeletonNode node{ parent, -1, -1, src.transformation, glm::mat4(1.0f) };
+		auto bone = std::find_if(bones_.begin(), bones_.end(),
+			[&](const Bone& b) { return b.GetBoneName() == src.name; });
+		if (bone != bones_.end()) node.bone = static_cast<int>(bone - bones_.begin());
+		if (auto iter = bone_info_map_.find(src.name); iter != bone_info_map_.end()) {
+			node.palette = iter->second.id;
+			node.offset	 = iter->second.offset;
+		}
+
+		int idx = static_cast<int>(nodes_.size());
+		nodes_.push_back(node);
+		for (const AssimpNodeData& child : src.children) {
+			FlattenHierarchy(child, idx);
+		}
+	}
+
 // Fields
 // -----------------------------------------------------
 private:
@@ -93,6 +157,8 @@ private:
 	int	  ticks_per_second_;
 	std::vector<Bone>				bones_;
 	AssimpNodeData					root_node_;
+	std::vector<SkeletonNode>		nodes_;
+	AnimationClip					clip_;		// the keys of bones_, reduced and in SoA form
 	std::map<std::string, BoneInfo> bone_info_map_;
 };
 
@@ -0,0 +1,472 @@
+#ifndef __ANIMATION_CLIP_H
+#define __ANIMATION_CLIP_H
+
+#include "bone.h"
+#include "simd_float.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// index i of the segment [times[i], times[i + 1]] holding time, times needs at least two entries.
+// Same cursor scheme as Bone::GetIdxFromVector: a few steps forward from the last answer, else a binary search
+template<class T>
+int FindKeySegment(std::span<const T> times, float time, int& cursor)
+{
+	constexpr int kForwardSteps = 4;
+	int last = static_cast<int>(times.size()) - 2;
+	cursor = std::clamp(cursor, 0, last);
+	if (time >= times[cursor]) {
+		for (int i = 0; i < kForwardSteps; ++i) {
+			if (cursor == last || time < times[cursor + 1]) return cursor;
+			++cursor;
+		}
+	}
+	auto next = std::upper_bound(times.begin() + 1, times.end() - 1, time,
+		[](float t, const T& key) { return t < key; });
+	cursor = static_cast<int>(next - times.begin()) - 1;
+	return cursor;
+}
+
+// tolerances of the load time key reduction, the largest error a sampled key may have against the
+// key as imported. 0 only drops keys the interpolation reproduces exactly. Rotations can not get below
+// their quantization, about 1.3e-4 radians: with a smaller tolerance every rotation key is kept
+struct ClipCompression {
+	float position_error = 1e-3f;	// model units
+	float rotation_error = 1e-3f;	// radians
+	float scale_error	 = 1e-4f;
+};
+
+// what compressing a clip saved and cost, measured against the keys as imported
+struct ClipStats {
+	size_t raw_keys			  = 0;
+	size_t keys				  = 0;
+	size_t raw_bytes		  = 0;	// the imported keys as Bone stores them
+	size_t bytes			  = 0;	// the AnimationClip
+	float  max_position_error = 0.0f;
+	float  max_rotation_error = 0.0f;	// radians
+	float  max_scale_error	  = 0.0f;
+
+	inline float Ratio() const { return bytes ? static_cast<float>(raw_bytes) / bytes : 0.0f; }
+};
+
+// The keys of every bone track of an animation in structure-of-arrays form: per channel one array of
+// key times and the values, the keys of track i at [first[i], first[i] + count[i]). Track i is
+// Animation's bone i.
+//
+// Key times are 16-bit frame indices: multiples of the key spacing when every key sits on that grid and
+// the clip is short enough, else 1/65535 of the last key time, which rounds key times. Rotations are stored smallest-three, the largest
+// component is dropped (rebuilt from the unit length) and the other three take 15 bits each.
+//
+// Building a clip drops every key that the interpolation between the keys kept around it reproduces
+// within ClipCompression. The test runs on the keys as stored, decoded rotations at rounded frames,
+// against the imported keys, so Stats() reports the error a sampler actually sees.
+class AnimationClip {
+public:
+	// one of position, rotation, scale
+	struct Channel {
+		std::vector<uint32_t>			  first;
+		std::vector<uint32_t>			  count;
+		std::vector<uint16_t>			  frame;	// key time / TimeStep()
+		std::array<std::vector<float>, 3> value;	// position, scale: x, y, z
+		std::vector<uint16_t>			  packed;	// rotation: 3 words per key, see EncodeRotation
+	};
+
+	// the keys of one segment and the blend factor between them
+	struct KeyBlend {
+		uint32_t a;
+		uint32_t b;
+		float	 t;
+	};
+
+	AnimationClip() = default;
+
+	// the keys of bones[i] become track i, bones are only read here
+	explicit AnimationClip(const std::vector<Bone>& bones, const ClipCompression& compression = {}) {
+		// the key spacing when every key time is a multiple of it, as for clips sampled at a fixed rate
+		float last_time = 0.0f, spacing = 0.0f;
+		auto scan_spacing = [&](const auto& keys) {
+			for (size_t i = 0; i < keys.size(); ++i) {
+				last_time = std::max(last_time, keys[i].timestamp);
+				float gap = i > 0 ? keys[i].timestamp - keys[i - 1].timestamp : 0.0f;
+				if (gap > 1e-4f && (spacing == 0.0f || gap < spacing)) spacing = gap;
+			}
+		};
+		bool on_grid = true;
+		auto scan_grid = [&](const auto& keys) {
+			for (const auto& key : keys) {
+				float frame = key.timestamp / spacing;
+				on_grid = on_grid && std::abs(frame - std::round(frame)) < 1e-3f;
+			}
+		};
+		for (const Bone& bone : bones) {
+			scan_spacing(bone.GetPositionKeys());
+			scan_spacing(bone.GetRotationKeys());
+			scan_spacing(bone.GetScaleKeys());
+		}
+		if (spacing > 0.0f) {
+			// the smallest gap carries the rounding of two key times, the clip length spreads it over all frames
+			spacing = last_time / std::round(last_time / spacing);
+			for (const Bone& bone : bones) {
+				scan_grid(bone.GetPositionKeys());
+				scan_grid(bone.GetRotationKeys());
+				scan_grid(bone.GetScaleKeys());
+			}
+		}
+		time_step_ = spacing > 0.0f && on_grid && last_time / spacing <= 65535.0f ? spacing : std::max(last_time, 1.0f) / 65535.0f;
+
+		auto mix = [](const glm::vec3& a, const glm::vec3& b, float t) { return glm::mix(a, b, t); };
+		for (const Bone& bone : bones) {
+			AppendTrack(position_, bone.GetPositionKeys(), compression.position_error, stats_.max_position_error,
+				[](const KeyPosition& key) { return key.pos; }, mix,
+				[](const glm::vec3& value, const KeyPosition& key) { return glm::distance(value, key.pos); },
+				[&](const KeyPosition* key) {
+					glm::vec3 value = key ? key->pos : glm::vec3(0.0f);
+					for (int c = 0; c < 3; ++c) position_.value[c].push_back(value[c]);
+				});
+			AppendTrack(rotation_, bone.GetRotationKeys(), compression.rotation_error, stats_.max_rotation_error,
+				[](const KeyRotation& key) {
+					float xyzw[4];
+					DecodeRotation(EncodeRotation(key.ori).data(), xyzw);
+					return glm::quat(xyzw[3], xyzw[0], xyzw[1], xyzw[2]);
+				},
+				[](const glm::quat& a, const glm::quat& b, float t) { return Bone::Nlerp(a, b, t); },
+				[](const glm::quat& value, const KeyRotation& key) { return Bone::RotationAngle(value, key.ori); },
+				[&](const KeyRotation* key) {
+					auto words = EncodeRotation(key ? key->ori : glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+					rotation_.packed.insert(rotation_.packed.end(), words.begin(), words.end());
+				});
+			AppendTrack(scale_, bone.GetScaleKeys(), compression.scale_error, stats_.max_scale_error,
+				[](const KeyScale& key) { return key.scale; }, mix,
+				[](const glm::vec3& value, const KeyScale& key) { return glm::distance(value, key.scale); },
+				[&](const KeyScale* key) {
+					glm::vec3 value = key ? key->scale : glm::vec3(1.0f);
+					for (int c = 0; c < 3; ++c) scale_.value[c].push_back(value[c]);
+				});
+			stats_.raw_keys	 += bone.GetPositionKeys().size() + bone.GetRotationKeys().size() + bone.GetScaleKeys().size();
+			stats_.raw_bytes += bone.GetPositionKeys().size() * sizeof(KeyPosition) + bone.GetRotationKeys().size() * sizeof(KeyRotation)
+				+ bone.GetScaleKeys().size() * sizeof(KeyScale);
+		}
+		for (const Channel* channel : { &position_, &rotation_, &scale_ })
+			stats_.keys += channel->frame.size();
+		stats_.bytes = Bytes();
+	}
+
+	inline size_t		  TrackCount() const { return position_.first.size(); }
+	inline float		  TimeStep()   const { return time_step_; }
+	inline const Channel& Position()   const { return position_; }
+	inline const Channel& Rotation()   const { return rotation_; }
+	inline const Channel& Scale()	   const { return scale_; }
+	inline const ClipStats& Stats()	   const { return stats_; }	// what building the clip saved and cost
+
+	size_t Bytes() const {
+		size_t bytes = 0;
+		for (const Channel* channel : { &position_, &rotation_, &scale_ }) {
+			bytes += (channel->first.size() + channel->count.size()) * sizeof(uint32_t);
+			bytes += (channel->frame.size() + channel->packed.size()) * sizeof(uint16_t);
+			for (const auto& value : channel->value) bytes += value.size() * sizeof(float);
+		}
+		return bytes;
+	}
+
+	// the keys around frame (a time divided by TimeStep()) in one track, cursor as for FindKeySegment
+	static KeyBlend Blend(const Channel& channel, size_t track, float frame, int& cursor) {
+		uint32_t first = channel.first[track], count = channel.count[track];
+		if (count == 1) return { first, first, 0.0f };
+		std::span<const uint16_t> frames(channel.frame.data() + first, count);
+		int i = FindKeySegment(frames, frame, cursor);
+		return { first + i, first + i + 1, SegmentFactor(frames[i], frames[i + 1], frame) };
+	}
+
+	// blend factor of frame between the keys at frames a and b
+	static float SegmentFactor(uint16_t a, uint16_t b, float frame) {
+		float span = static_cast<float>(b) - a;
+		return span > 0.0f ? std::clamp((frame - a) / span, 0.0f, 1.0f) : 0.0f;
+	}
+
+	// smallest three: bits 15 of the first two words hold the index of the dropped component (x, y, z, w),
+	// the low 15 bits of each word one of the others in [-1/sqrt(2), 1/sqrt(2)]
+	static std::array<uint16_t, 3> EncodeRotation(const glm::quat& rotation) {
+		glm::quat q = glm::normalize(rotation);
+		float comps[4] = { q.x, q.y, q.z, q.w };
+		int largest = 0;
+		for (int c = 1; c < 4; ++c)
+			if (std::abs(comps[c]) > std::abs(comps[largest])) largest = c;
+		// q and -q are the same rotation, flip so the dropped component is positive
+		float sign = comps[largest] < 0.0f ? -1.0f : 1.0f;
+		std::array<uint16_t, 3> words{};
+		for (int c = 0, w = 0; c < 4; ++c) {
+			if (c == largest) continue;
+			float unit = std::clamp(comps[c] * sign * kSqrt2 * 0.5f + 0.5f, 0.0f, 1.0f);
+			words[w++] = static_cast<uint16_t>(std::lround(unit * kComponentMax));
+		}
+		words[0] |= static_cast<uint16_t>((largest >> 1) << 15);
+		words[1] |= static_cast<uint16_t>((largest & 1) << 15);
+		return words;
+	}
+
+	// x, y, z, w of the unit quaternion in words
+	static void DecodeRotation(const uint16_t* words, float* xyzw) {
+		int largest = ((words[0] >> 15) << 1) | (words[1] >> 15);
+		float sum = 0.0f;
+		for (int c = 0, w = 0; c < 4; ++c) {
+			if (c == largest) continue;
+			float value = ((words[w++] & kComponentMax) / static_cast<float>(kComponentMax) * 2.0f - 1.0f) / kSqrt2;
+			xyzw[c] = value;
+			sum += value * value;
+		}
+		xyzw[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+	}
+
+	// single track lookups, for tools and the scalar path of Animator; poses are sampled through PoseSampler.
+	// cursor as for FindKeySegment, the overloads without one search from the start
+	glm::vec3 SamplePosition(size_t track, float time, int& cursor) const { return SampleVector(position_, track, time, cursor); }
+	glm::vec3 SampleScale(size_t track, float time, int& cursor)	const { return SampleVector(scale_, track, time, cursor); }
+	glm::quat SampleRotation(size_t track, float time, int& cursor) const {
+		KeyBlend blend = Blend(rotation_, track, time / time_step_, cursor);
+		float a[4], b[4];
+		DecodeRotation(&rotation_.packed[blend.a * 3], a);
+		DecodeRotation(&rotation_.packed[blend.b * 3], b);
+		return Bone::Nlerp(glm::quat(a[3], a[0], a[1], a[2]), glm::quat(b[3], b[0], b[1], b[2]), blend.t);
+	}
+
+	glm::vec3 SamplePosition(size_t track, float time) const { int cursor = 0; return SamplePosition(track, time, cursor); }
+	glm::vec3 SampleScale(size_t track, float time)	   const { int cursor = 0; return SampleScale(track, time, cursor); }
+	glm::quat SampleRotation(size_t track, float time) const { int cursor = 0; return SampleRotation(track, time, cursor); }
+
+	// parent space transform of track at time, cursors holds the position, rotation and scale cursor
+	glm::mat4 SampleTransform(size_t track, float time, int* cursors) const {
+		glm::mat4 translation = glm::translate(glm::mat4(1.0f), SamplePosition(track, time, cursors[0]));
+		glm::mat4 rotation	  = glm::toMat4(SampleRotation(track, time, cursors[1]));
+		glm::mat4 scale		  = glm::scale(glm::mat4(1.0f), SampleScale(track, time, cursors[2]));
+		return translation * rotation * scale;
+	}
+
+private:
+	static constexpr float	  kSqrt2		= 1.41421356f;
+	static constexpr uint16_t kComponentMax = 0x7fff;
+	static constexpr size_t	  kMaxSegmentKeys	 = 1024;
+	static constexpr int	  kMaxReduceAttempts = 3;
+
+	// reduces keys within tolerance and appends the kept ones. store gives a key's value as the clip holds
+	// it, push appends a key's data to the channel; a track without keys gets a single identity key (push
+	// gets nullptr), so the sampler never checks for empty tracks. max_error grows to the track's error
+	template<class Key, class Store, class Lerp, class Distance, class Push>
+	void AppendTrack(Channel& channel, const std::vector<Key>& keys, float tolerance, float& max_error,
+		Store&& store, Lerp&& lerp, Distance&& distance, Push&& push)
+	{
+		channel.first.push_back(static_cast<uint32_t>(channel.frame.size()));
+		if (keys.empty()) {
+			channel.count.push_back(1);
+			channel.frame.push_back(0);
+			push(static_cast<const Key*>(nullptr));
+			return;
+		}
+
+		// what a sampler sees of key i: the stored value at frames[i], looked up at time / time_step_
+		const size_t n = keys.size();
+		using Value = decltype(store(keys.front()));
+		std::vector<Value>	  stored(n);
+		std::vector<uint16_t> frames(n);
+		for (size_t i = 0; i < n; ++i) {
+			stored[i] = store(keys[i]);
+			frames[i] = static_cast<uint16_t>(std::clamp(std::round(keys[i].timestamp / time_step_), 0.0f, 65535.0f));
+		}
+		auto frame_of = [&](size_t i) { return keys[i].timestamp / time_step_; };
+
+		// keys between the last kept key and the candidate end are dropped while the interpolation between
+		// the two reproduces every one of them; a segment is cut at kMaxSegmentKeys to bound the load time
+		auto reduce = [&](float limit) {
+			std::vector<uint32_t> kept{ 0 };
+			bool constant = std::all_of(keys.begin(), keys.end(),
+				[&](const Key& key) { return distance(stored[0], key) <= limit; });
+			if (constant) return kept;
+			size_t anchor = 0;
+			for (size_t end = 2; end < n; ++end) {
+				bool fits = end - anchor <= kMaxSegmentKeys;
+				for (size_t i = anchor + 1; fits && i < end; ++i) {
+					float t = SegmentFactor(frames[anchor], frames[end], frame_of(i));
+					fits = distance(lerp(stored[anchor], stored[end], t), keys[i]) <= limit;
+				}
+				if (!fits) {
+					anchor = end - 1;
+					kept.push_back(static_cast<uint32_t>(anchor));
+				}
+			}
+			kept.push_back(static_cast<uint32_t>(n - 1));
+			return kept;
+		};
+
+		// largest error over all imported keys, looked up the way Blend does. Only differs from the greedy
+		// test where rounding moved a key time into a neighbouring segment
+		auto measure = [&](const std::vector<uint32_t>& kept) {
+			std::vector<uint16_t> kept_frames;
+			kept_frames.reserve(kept.size());
+			for (uint32_t k : kept) kept_frames.push_back(frames[k]);
+			float worst	 = 0.0f;
+			int	  cursor = 0;
+			for (size_t i = 0; i < n; ++i) {
+				Value value = stored[kept[0]];
+				if (kept.size() > 1) {
+					int s = FindKeySegment(std::span<const uint16_t>(kept_frames), frame_of(i), cursor);
+					value = lerp(stored[kept[s]], stored[kept[s + 1]], SegmentFactor(kept_frames[s], kept_frames[s + 1], frame_of(i)));
+				}
+				worst = std::max(worst, distance(value, keys[i]));
+			}
+			return worst;
+		};
+
+		// a track the rounding pushed over the tolerance is reduced again with a tighter test, and keeps
+		// every key in the end
+		std::vector<uint32_t> kept;
+		float error = 0.0f, limit = tolerance;
+		for (int attempt = 0; ; ++attempt) {
+			kept  = reduce(limit);
+			error = measure(kept);
+			if (error <= tolerance || kept.size() == n) break;
+			if (attempt == kMaxReduceAttempts) {
+				kept.resize(n);
+				for (size_t i = 0; i < n; ++i) kept[i] = static_cast<uint32_t>(i);
+				error = measure(kept);
+				break;
+			}
+			limit *= 0.5f;
+		}
+		max_error = std::max(max_error, error);
+
+		channel.count.push_back(static_cast<uint32_t>(kept.size()));
+		for (uint32_t k : kept) {
+			channel.frame.push_back(frames[k]);
+			push(&keys[k]);
+		}
+	}
+
+	glm::vec3 SampleVector(const Channel& channel, size_t track, float time, int& cursor) const {
+		KeyBlend blend = Blend(channel, track, time / time_step_, cursor);
+		glm::vec3 a, b;
+		for (int c = 0; c < 3; ++c) {
+			a[c] = channel.value[c][blend.a];
+			b[c] = channel.value[c][blend.b];
+		}
+		return glm::mix(a, b, blend.t);
+	}
+
+private:
+	Channel position_;
+	Channel rotation_;
+	Channel scale_;
+	float	time_step_ = 1.0f;	// ticks per frame index
+	ClipStats stats_;
+};
+
+// Samples every track of a clip into a contiguous buffer of local transforms, SimdFloat::kWidth bones at
+// a time: positions and scales are lerped, rotations nlerped along the shorter arc, and the TRS matrix
+// is written straight from the quaternion, scale and translation without building three matrices.
+// Finding the keys stays scalar, per track and channel through a cursor kept by the sampler, so each
+// animated character owns one.
+class PoseSampler {
+public:
+	void Sample(const AnimationClip& clip, float time, std::span<glm::mat4> out) {
+		constexpr int W = SimdFloat::kWidth;
+		size_t tracks = std::min(clip.TrackCount(), out.size());
+		if (cursors_.size() != clip.TrackCount() * 3) cursors_.assign(clip.TrackCount() * 3, 0);
+		float frame = time / clip.TimeStep();
+
+		// a/b: the keys around time, t: the blend factor; one row per component, one column per lane
+		alignas(SimdFloat::kAlign) float pos[7][W];
+		alignas(SimdFloat::kAlign) float rot[9][W];
+		alignas(SimdFloat::kAlign) float scl[7][W];
+		alignas(SimdFloat::kAlign) float mat[12][W];
+
+		for (size_t base = 0; base < tracks; base += W) {
+			int lanes = static_cast<int>(std::min<size_t>(W, tracks - base));
+			for (int lane = 0; lane < W; ++lane) {
+				// unused lanes repeat the last track, their results are dropped
+				size_t track = base + std::min(lane, lanes - 1);
+				GatherVector(clip.Position(), track, frame, cursors_[track * 3 + 0], pos, lane);
+				GatherRotation(clip.Rotation(), track, frame, cursors_[track * 3 + 1], rot, lane);
+				GatherVector(clip.Scale(),	  track, frame, cursors_[track * 3 + 2], scl, lane);
+			}
+
+			SimdFloat pt = SimdFloat::Load(pos[6]), rt = SimdFloat::Load(rot[8]), st = SimdFloat::Load(scl[6]);
+			SimdFloat tx = Lerp(SimdFloat::Load(pos[0]), SimdFloat::Load(pos[3]), pt);
+			SimdFloat ty = Lerp(SimdFloat::Load(pos[1]), SimdFloat::Load(pos[4]), pt);
+			SimdFloat tz = Lerp(SimdFloat::Load(pos[2]), SimdFloat::Load(pos[5]), pt);
+			SimdFloat sx = Lerp(SimdFloat::Load(scl[0]), SimdFloat::Load(scl[3]), st);
+			SimdFloat sy = Lerp(SimdFloat::Load(scl[1]), SimdFloat::Load(scl[4]), st);
+			SimdFloat sz = Lerp(SimdFloat::Load(scl[2]), SimdFloat::Load(scl[5]), st);
+
+			// nlerp, b is negated when the quaternions are in opposite hemispheres
+			SimdFloat ax = SimdFloat::Load(rot[0]), ay = SimdFloat::Load(rot[1]), az = SimdFloat::Load(rot[2]), aw = SimdFloat::Load(rot[3]);
+			SimdFloat bx = SimdFloat::Load(rot[4]), by = SimdFloat::Load(rot[5]), bz = SimdFloat::Load(rot[6]), bw = SimdFloat::Load(rot[7]);
+			SimdFloat dot = ax * bx + ay * by + az * bz + aw * bw;
+			SimdFloat qx = Lerp(ax, MulSign(bx, dot), rt);
+			SimdFloat qy = Lerp(ay, MulSign(by, dot), rt);
+			SimdFloat qz = Lerp(az, MulSign(bz, dot), rt);
+			SimdFloat qw = Lerp(aw, MulSign(bw, dot), rt);
+			SimdFloat inv_len = SimdFloat::Splat(1.0f) / Sqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+			qx = qx * inv_len; qy = qy * inv_len; qz = qz * inv_len; qw = qw * inv_len;
+
+			// columns of T * R * S
+			SimdFloat one = SimdFloat::Splat(1.0f), two = SimdFloat::Splat(2.0f);
+			SimdFloat xx = qx * qx, yy = qy * qy, zz = qz * qz;
+			SimdFloat xy = qx * qy, xz = qx * qz, yz = qy * qz;
+			SimdFloat wx = qw * qx, wy = qw * qy, wz = qw * qz;
+			((one - two * (yy + zz)) * sx).Store(mat[0]);
+			(two * (xy + wz) * sx).Store(mat[1]);
+			(two * (xz - wy) * sx).Store(mat[2]);
+			(two * (xy - wz) * sy).Store(mat[3]);
+			((one - two * (xx + zz)) * sy).Store(mat[4]);
+			(two * (yz + wx) * sy).Store(mat[5]);
+			(two * (xz + wy) * sz).Store(mat[6]);
+			(two * (yz - wx) * sz).Store(mat[7]);
+			((one - two * (xx + yy)) * sz).Store(mat[8]);
+			tx.Store(mat[9]);
+			ty.Store(mat[10]);
+			tz.Store(mat[11]);
+
+			for (int lane = 0; lane < lanes; ++lane) {
+				glm::mat4& m = out[base + lane];
+				for (int c = 0; c < 4; ++c) {
+					m[c] = glm::vec4(mat[c * 3 + 0][lane], mat[c * 3 + 1][lane], mat[c * 3 + 2][lane], c == 3 ? 1.0f : 0.0f);
+				}
+			}
+		}
+	}
+
+private:
+	// writes keys a and b of one track into rows [0, 3) and [3, 6) of rows, the factor into row 6
+	template<size_t Rows, int W>
+	static void GatherVector(const AnimationClip::Channel& channel, size_t track, float frame, int& cursor, float (&rows)[Rows][W], int lane) {
+		AnimationClip::KeyBlend blend = AnimationClip::Blend(channel, track, frame, cursor);
+		for (int c = 0; c < 3; ++c) {
+			rows[c][lane]	  = channel.value[c][blend.a];
+			rows[3 + c][lane] = channel.value[c][blend.b];
+		}
+		rows[6][lane] = blend.t;
+	}
+
+	// the same for rotations, decoded into x, y, z, w rows
+	template<size_t Rows, int W>
+	static void GatherRotation(const AnimationClip::Channel& channel, size_t track, float frame, int& cursor, float (&rows)[Rows][W], int lane) {
+		AnimationClip::KeyBlend blend = AnimationClip::Blend(channel, track, frame, cursor);
+		float a[4], b[4];
+		AnimationClip::DecodeRotation(&channel.packed[blend.a * 3], a);
+		AnimationClip::DecodeRotation(&channel.packed[blend.b * 3], b);
+		for (int c = 0; c < 4; ++c) {
+			rows[c][lane]	  = a[c];
+			rows[4 + c][lane] = b[c];
+		}
+		rows[8][lane] = blend.t;
+	}
+
+private:
+	std::vector<int> cursors_;	// position, rotation, scale per track
+};
+
+#endif // !__ANIMATION_CLIP_H
@@ -0,0 +1,69 @@
+#ifndef __ANIMATION_CROWD_H
+#define __ANIMATION_CROWD_H
+
+#include "animator.h"
+#include "thread_pool.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <span>
+#include <vector>
+
+// Many animated characters, each an Animator with its own clip, time and speed, updated in parallel on a
+// thread pool. Palettes are written into one contiguous buffer, Animator::kMaxBones matrices per
+// character in the order they were added, so the whole crowd is uploaded with a single copy.
+//
+// Characters are split into chunks of a few so that workers stealing from each other balance the load
+// without one task per character. Sampling always goes through the SIMD pose sampler.
+class AnimationCrowd {
+public:
+	explicit AnimationCrowd(ThreadPool& pool = ThreadPool::Global()):
+		pool_(pool)
+	{}
+
+	// start_time in ticks, speed scales dt; returns the character's index
+	size_t Add(Animation* animation, float start_time = 0.0f, float speed = 1.0f) {
+		Animator& animator = animators_.emplace_back(animation);
+		animator.SetTime(start_time);
+		animator.SetSimdSampling(true);
+		speeds_.push_back(speed);
+		palettes_.resize(animators_.size() * Animator::kMaxBones, glm::mat4(1.0f));
+		return animators_.size() - 1;
+	}
+
+	void Clear() {
+		animators_.clear();
+		speeds_.clear();
+		palettes_.clear();
+	}
+
+	// advances every character by dt and writes its palette; max_threads limits the threads taking
+	// part, the caller included, 0 for the whole pool
+	void Update(float dt, size_t max_threads = 0) {
+		size_t chunks = (animators_.size() + kChunkSize - 1) / kChunkSize;
+		pool_.ParallelFor(chunks, [&](size_t chunk) {
+			size_t end = std::min(animators_.size(), (chunk + 1) * kChunkSize);
+			for (size_t i = chunk * kChunkSize; i < end; ++i) {
+				animators_[i].UpdateAnimation(dt * speeds_[i], Palette(i));
+			}
+		}, max_threads);
+	}
+
+	inline std::span<glm::mat4> Palette(size_t i) {
+		return std::span<glm::mat4>(palettes_).subspan(i * Animator::kMaxBones, Animator::kMaxBones);
+	}
+
+	inline const std::vector<glm::mat4>& Palettes() const { return palettes_; }
+	inline size_t						 Size()		const { return animators_.size(); }
+
+private:
+	static constexpr size_t kChunkSize = 16;
+
+	ThreadPool&			   pool_;
+	std::vector<Animator>  animators_;
+	std::vector<float>	   speeds_;
+	std::vector<glm::mat4> palettes_;	// Animator::kMaxBones per character
+};
+
+#endif // !__ANIMATION_CROWD_H
@@ -6,51 +6,78 @@
 
 #include <glm/glm.hpp>
 
+#include <span>
 #include <vector>
 
 class Animator {
 public:
+	// length of a palette, matches kMaxBones in skelanim.vert: the bound its bone ids are checked against,
+	// and the array length of the BonePalette uniform block when palettes are not read from storage buffers
+	static constexpr size_t kMaxBones = 100;
+
 	Animator(Animation* animation):
 		cur_time_(0.0f), cur_animation_(animation)
 	{		
-		bone_matrices_.resize(100, glm::mat4(1.0f));		
+		bone_matrices_.resize(kMaxBones, glm::mat4(1.0f));		
+		if (cur_animation_) {
+			global_transforms_.resize(cur_animation_->GetNodes().size());
+			local_pose_.resize(cur_animation_->GetClip().TrackCount());
+			scalar_cursors_.resize(local_pose_.size() * 3);
+		}
 	}
 
 	void UpdateAnimation(float dt) {
+		UpdateAnimation(dt, bone_matrices_);
+	}
+
+	// same, but the palette goes to a buffer owned by the caller, see AnimationCrowd
+	void UpdateAnimation(float dt, std::span<glm::mat4> palette) {
 		delta_time_ = dt;
 		if (cur_animation_) {
 			cur_time_ += cur_animation_->GetTickPerSecond() * dt;
 			cur_time_ = fmod(cur_time_, cur_animation_->GetDuration());
-			CalculateBoneTransform(&cur_animation_->GetRootNode(), glm::mat4(1.0f));
+			CalculateBoneTransforms(palette);
 		}
 	}
 
 	void PlayAnimation(Animation* p_animation) {
 		cur_animation_ = p_animation;
 		cur_time_ = 0.0f;
+		global_transforms_.resize(cur_animation_ ? cur_animation_->GetNodes().size() : 0);
+		local_pose_.resize(cur_animation_ ? cur_animation_->GetClip().TrackCount() : 0);
+		scalar_cursors_.assign(local_pose_.size() * 3, 0);
 	}
 
-	void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parent_transform) {
-		std::string name = node->name;
-		glm::mat4   node_transform = node->transformation;
+	// in ticks, wrapped into the clip on the next update
+	inline void SetTime(float time) { cur_time_ = time; }
 
-		Bone* bone = cur_animation_->FindBone(name);
+	// off: every track is sampled on its own through AnimationClip::SampleTransform, for comparison
+	inline void SetSimdSampling(bool simd) { simd_sampling_ = simd; }
 
-		if (bone) {
-			bone->Update(cur_time_);
-			node_transform = bone->GetLocalTransform();
-		}
+	// samples all tracks into local_pose_, then one pass over the flattened hierarchy,
+	// parents are computed before their children
+	void CalculateBoneTransforms() {
+		CalculateBoneTransforms(bone_matrices_);
+	}
 
-		glm::mat4 glb_transform = parent_transform * node_transform;
-		auto bone_info_map = cur_animation_->GetBoneIDMap();
-		if (auto iter = bone_info_map.find(name);iter != bone_info_map.end()) {		
-			int idx = iter->second.id;
-			glm::mat4 offset = iter->second.offset;
-			bone_matrices_[idx] = glb_transform * offset;
-		}
+	void CalculateBoneTransforms(std::span<glm::mat4> palette) {
+		if (simd_sampling_) sampler_.Sample(cur_animation_->GetClip(), cur_time_, local_pose_);
+		const std::vector<SkeletonNode>& nodes = cur_animation_->GetNodes();
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			const SkeletonNode& node = nodes[i];
+			glm::mat4 node_transform = node.transform;
+			if (node.bone >= 0 && simd_sampling_) {
+				node_transform = local_pose_[node.bone];
+			}
+			else if (node.bone >= 0) {
+				node_transform = cur_animation_->GetClip().SampleTransform(node.bone, cur_time_, &scalar_cursors_[node.bone * 3]);
+			}
 
-		for (int i = 0; i < node->children_count; ++i) {
-			CalculateBoneTransform(&node->children[i], glb_transform);
+			glm::mat4& glb_transform = global_transforms_[i];
+			glb_transform = node.parent < 0 ? node_transform : global_transforms_[node.parent] * node_transform;
+			if (node.palette >= 0 && node.palette < static_cast<int>(palette.size())) {
+				palette[node.palette] = glb_transform * node.offset;
+			}
 		}
 	}
 
@@ -59,6 +86,11 @@ public:
 
 private:
 	std::vector<glm::mat4> bone_matrices_;
+	std::vector<glm::mat4> global_transforms_;	// per SkeletonNode, model space
+	std::vector<glm::mat4> local_pose_;			// per clip track, parent space
+	std::vector<int>	   scalar_cursors_;		// position, rotation, scale per clip track, for the scalar path
+	PoseSampler			   sampler_;
+	bool				   simd_sampling_ = true;
 	Animation*			   cur_animation_;
 	float				   cur_time_;
 	float				   delta_time_;
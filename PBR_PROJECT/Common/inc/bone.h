@@ -11,6 +11,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <concepts>
 #include <vector>
 #include <string>
@@ -38,11 +40,13 @@ struct KeyScale {
 class Bone {
 private:
 	std::vector<KeyPosition> k_pos_;
-	int kpos_size_;
 	std::vector<KeyRotation> k_rot_;
-	int krot_size_;
 	std::vector<KeyScale>	 k_scale_;
-	int kscale_size_;
+
+	// key of the last lookup per track, see GetIdxFromVector
+	int pos_cursor_	  = 0;
+	int rot_cursor_	  = 0;
+	int scale_cursor_ = 0;
 
 	glm::mat4   local_transform_;
 	std::string name_;
@@ -56,38 +60,29 @@ public:
 		local_transform_(1.0f) {
 		// insert pos data
 		// -------------------------------------
-		kpos_size_ = channel->mNumPositionKeys;
-		k_pos_.reserve(kpos_size_);
-		for (int i = 0; i < kpos_size_; ++i) {
-			aiVector3D ai_pos = channel->mPositionKeys[i].mValue;
-			float time_stamp = channel->mPositionKeys[i].mTime;
+		k_pos_.reserve(channel->mNumPositionKeys);
+		for (unsigned int i = 0; i < channel->mNumPositionKeys; ++i) {
 			KeyPosition data;
-			data.pos = toVec3(ai_pos);
-			data.timestamp = time_stamp;
+			data.pos = toVec3(channel->mPositionKeys[i].mValue);
+			data.timestamp = static_cast<float>(channel->mPositionKeys[i].mTime);
 			k_pos_.push_back(data);
 		}
 		// inset rot data
 		// -------------------------------------
-		krot_size_ = channel->mNumRotationKeys;
-		k_rot_.reserve(krot_size_);
-		for (int i = 0; i < krot_size_; ++i) {
-			aiQuaternion ai_rot = channel->mRotationKeys[i].mValue;
-			float time_stamp = channel->mRotationKeys[i].mTime;
+		k_rot_.reserve(channel->mNumRotationKeys);
+		for (unsigned int i = 0; i < channel->mNumRotationKeys; ++i) {
 			KeyRotation data;
-			data.ori = toQuat(ai_rot);
-			data.timestamp = time_stamp;
+			data.ori = toQuat(channel->mRotationKeys[i].mValue);
+			data.timestamp = static_cast<float>(channel->mRotationKeys[i].mTime);
 			k_rot_.push_back(data);
 		}
 		// inset scale data
 		// -------------------------------------
-		kscale_size_ = channel->mNumScalingKeys;
-		k_scale_.reserve(kscale_size_);
-		for (int i = 0; i < kscale_size_; ++i) {
-			aiVector3D scale = channel->mScalingKeys[i].mValue;
-			float time_stamp = channel->mRotationKeys[i].mTime;
+		k_scale_.reserve(channel->mNumScalingKeys);
+		for (unsigned int i = 0; i < channel->mNumScalingKeys; ++i) {
 			KeyScale data;
-			data.scale = toVec3(scale);
-			data.timestamp = time_stamp;
+			data.scale = toVec3(channel->mScalingKeys[i].mValue);
+			data.timestamp = static_cast<float>(channel->mScalingKeys[i].mTime);
 			k_scale_.push_back(data);
 		}
 	}
@@ -103,32 +98,67 @@ public:
 	inline std::string  GetBoneName() const { return name_; }
 	inline int			GetBoneID() { return id_; }
 
+	inline const std::vector<KeyPosition>& GetPositionKeys() const { return k_pos_; }
+	inline const std::vector<KeyRotation>& GetRotationKeys() const { return k_rot_; }
+	inline const std::vector<KeyScale>&	   GetScaleKeys()	 const { return k_scale_; }
+
+	// frees the keys once an AnimationClip holds them; Update then leaves the local transform at identity
+	void ReleaseKeys() {
+		k_pos_	 = {};
+		k_rot_	 = {};
+		k_scale_ = {};
+	}
+
+	// normalized lerp along the shorter arc, what PoseSampler interpolates rotations with
+	static glm::quat Nlerp(const glm::quat& a, const glm::quat& b, float t) {
+		glm::quat end = glm::dot(a, b) < 0.0f ? -b : b;
+		return glm::normalize(a * (1.0f - t) + end * t);
+	}
 
+	// angle in radians of the rotation taking a to b. From the chord rather than acos of the dot product,
+	// which has no precision left for the small angles the reduction compares
+	static float RotationAngle(const glm::quat& a, const glm::quat& b) {
+		glm::quat na = glm::normalize(a), nb = glm::normalize(b);
+		glm::vec4 va(na.x, na.y, na.z, na.w), vb(nb.x, nb.y, nb.z, nb.w);
+		if (glm::dot(va, vb) < 0.0f) vb = -vb;
+		return 4.0f * std::atan2(glm::length(va - vb), glm::length(va + vb));
+	}
 
+	// index i of the segment [vals[i], vals[i + 1]] holding time, vals needs at least two keys.
+	// cursor keeps the answer of the previous call: playing forward it moves by a key or so, which is
+	// checked first, a seek or a loop back falls to a binary search. Times before the first or after
+	// the last key give the first or last segment, GetScaleFactor clamps within it
 	template<class T>
 		requires requires (T x) { x.timestamp; }
-	int GetIdxFromVector(float time, std::vector<T>& vals) {
-		for (int i = 0; i < vals.size() - 1; ++i) {
-			if (time < vals[i + 1].timestamp) {
-				return i;
+	static int GetIdxFromVector(float time, const std::vector<T>& vals, int& cursor) {
+		constexpr int kForwardSteps = 4;
+		int last = static_cast<int>(vals.size()) - 2;
+		cursor = std::clamp(cursor, 0, last);
+		if (time >= vals[cursor].timestamp) {
+			for (int i = 0; i < kForwardSteps; ++i) {
+				if (cursor == last || time < vals[cursor + 1].timestamp) return cursor;
+				++cursor;
 			}
 		}
-		assert(0);
+		auto next = std::upper_bound(vals.begin() + 1, vals.end() - 1, time,
+			[](float t, const T& key) { return t < key.timestamp; });
+		cursor = static_cast<int>(next - vals.begin()) - 1;
+		return cursor;
 	}
 
 private:
-	float GetScaleFactor(float last_time_stamp, float next_time_stamp, float time) {
-		float scale_factor = 0.0f;
+	static float GetScaleFactor(float last_time_stamp, float next_time_stamp, float time) {
 		float molecule = time - last_time_stamp;
 		float denominator = next_time_stamp - last_time_stamp;
-		scale_factor = molecule / denominator;
-		return scale_factor;
+		if (denominator <= 0.0f) return 0.0f;
+		return std::clamp(molecule / denominator, 0.0f, 1.0f);
 	}
 
 	glm::mat4 InterpolatePosition(float time) {
-		if (1 == kpos_size_) return glm::translate(glm::mat4(1.0f), k_pos_[0].pos);
+		if (k_pos_.empty()) return glm::mat4(1.0f);
+		if (1 == k_pos_.size()) return glm::translate(glm::mat4(1.0f), k_pos_[0].pos);
 
-		int prev_idx = GetIdxFromVector(time, k_pos_),
+		int prev_idx = GetIdxFromVector(time, k_pos_, pos_cursor_),
 			next_idx = prev_idx + 1;
 
 		KeyPosition& prev_pos = k_pos_[prev_idx],
@@ -141,12 +171,13 @@ private:
 	}
 
 	glm::mat4 InterpolateRotation(float time) {
-		if (1 == krot_size_) {
+		if (k_rot_.empty()) return glm::mat4(1.0f);
+		if (1 == k_rot_.size()) {
 			auto rotation = glm::normalize(k_rot_[0].ori);
 			return glm::toMat4(rotation);
 		}
 
-		int prev_idx = GetIdxFromVector(time, k_rot_),
+		int prev_idx = GetIdxFromVector(time, k_rot_, rot_cursor_),
 			next_idx = prev_idx + 1;
 		KeyRotation& prev_rot = k_rot_[prev_idx],
 			& next_rot = k_rot_[next_idx];
@@ -158,9 +189,10 @@ private:
 	}
 
 	glm::mat4 InterpolateScaling(float time) {
-		if (1 == kscale_size_) return glm::scale(glm::mat4(1.0f), k_scale_.front().scale);
+		if (k_scale_.empty()) return glm::mat4(1.0f);
+		if (1 == k_scale_.size()) return glm::scale(glm::mat4(1.0f), k_scale_.front().scale);
 
-		int prev_idx = GetIdxFromVector(time, k_scale_),
+		int prev_idx = GetIdxFromVector(time, k_scale_, scale_cursor_),
 			next_idx = prev_idx + 1;
 		KeyScale& prev_scale = k_scale_[prev_idx],
 			& next_scale = k_scale_[next_idx];
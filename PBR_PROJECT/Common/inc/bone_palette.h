@@ -0,0 +1,135 @@
+#ifndef __BONE_PALETTE_H
+#define __BONE_PALETTE_H
+
+#include "animator.h"
+#include "shader.h"
+#include "uniform_buffer.h"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <span>
+#include <string_view>
+
+// The bone palettes of every skinned character of a frame in one GL buffer, written with a single call
+// per frame. Character i owns the Animator::kMaxBones matrices at i * kMaxBones of what is handed to
+// Upload, e.g. AnimationCrowd::Palettes().
+//
+// With shader storage buffers (GL 4.3 or ARB_shader_storage_buffer_object) the whole buffer stays bound
+// to the BonePalettes block and a draw only sets the palette_offset uniform. Otherwise each draw binds
+// its character's range to the BonePalette uniform block; ranges are padded to the offset alignment.
+// skelanim.vert picks the block through Define().
+class BonePaletteBuffer {
+public:
+	static constexpr GLsizeiptr kPaletteBytes = Animator::kMaxBones * sizeof(glm::mat4);
+
+	BonePaletteBuffer():
+		storage_(StorageSupported())
+	{
+		glGenBuffers(1, &buffer_);
+		stride_ = kPaletteBytes;
+		if (!storage_) {
+			GLint alignment = 1;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+			alignment = std::max(alignment, 1);
+			stride_ = (kPaletteBytes + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	~BonePaletteBuffer() {
+		glDeleteBuffers(1, &buffer_);
+	}
+
+	BonePaletteBuffer(const BonePaletteBuffer&)			   = delete;
+	BonePaletteBuffer& operator=(const BonePaletteBuffer&) = delete;
+
+	static bool StorageSupported() {
+		return GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_shader_storage_buffer_object;
+	}
+
+	// the define skelanim.vert is built with for this context, empty for the uniform block
+	static std::string_view Define() {
+		return StorageSupported() ? "BONE_PALETTE_STORAGE" : "";
+	}
+
+	// replaces the contents with palettes, whole palettes only. The old storage is orphaned so the
+	// write never waits for draws of the previous frame
+	void Upload(std::span<const glm::mat4> palettes) {
+		Upload({ palettes });
+	}
+
+	// the same with the palettes split over several spans, written in order straight from each one
+	// (one glBufferSubData per span), e.g. a single character followed by AnimationCrowd::Palettes()
+	void Upload(std::initializer_list<std::span<const glm::mat4>> parts) {
+		count_ = 0;
+		for (std::span<const glm::mat4> part : parts) count_ += part.size() / Animator::kMaxBones;
+		if (count_ == 0) return;
+		GLenum	   target = storage_ ? GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER;
+		GLsizeiptr bytes  = static_cast<GLsizeiptr>(count_) * stride_;
+		capacity_ = std::max(capacity_, bytes);
+		glBindBuffer(target, buffer_);
+		glBufferData(target, capacity_, nullptr, GL_STREAM_DRAW);
+		if (stride_ == kPaletteBytes) {
+			GLintptr offset = 0;
+			for (std::span<const glm::mat4> part : parts) {
+				GLsizeiptr part_bytes = static_cast<GLsizeiptr>(part.size() / Animator::kMaxBones) * kPaletteBytes;
+				if (part_bytes == 0) continue;
+				glBufferSubData(target, offset, part_bytes, part.data());
+				offset += part_bytes;
+			}
+		}
+		else {
+			char* dst = static_cast<char*>(glMapBufferRange(target, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+			if (dst) {
+				ForEachPalette(parts, [&](size_t i, const glm::mat4* palette) {
+					std::memcpy(dst + i * stride_, palette, kPaletteBytes);
+				});
+			}
+			// a failed unmap leaves the buffer undefined, write the palettes one range each instead
+			if (!dst || glUnmapBuffer(target) == GL_FALSE) {
+				ForEachPalette(parts, [&](size_t i, const glm::mat4* palette) {
+					glBufferSubData(target, static_cast<GLintptr>(i) * stride_, kPaletteBytes, palette);
+				});
+			}
+		}
+		glBindBuffer(target, 0);
+		if (storage_) glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kBonePaletteBinding, buffer_);
+	}
+
+	// points the next draws at character's palette; offset is the program's palette_offset uniform,
+	// the program has to be in use
+	void Bind(size_t character, const Uniform<int>& offset) const {
+		if (character >= count_) return;
+		if (storage_) {
+			offset.set(static_cast<int>(character * Animator::kMaxBones));
+		}
+		else {
+			glBindBufferRange(GL_UNIFORM_BUFFER, kBonePaletteBinding, buffer_, static_cast<GLintptr>(character) * stride_, kPaletteBytes);
+		}
+	}
+
+	inline bool	  Storage() const { return storage_; }
+	inline size_t Count()	const { return count_; }
+	inline GLuint ID()		const { return buffer_; }
+
+private:
+	// func(index, first matrix) for every whole palette of parts, indices counting across them
+	template<class Func>
+	static void ForEachPalette(std::initializer_list<std::span<const glm::mat4>> parts, Func&& func) {
+		size_t index = 0;
+		for (std::span<const glm::mat4> part : parts)
+			for (size_t i = 0; i + Animator::kMaxBones <= part.size(); i += Animator::kMaxBones)
+				func(index++, part.data() + i);
+	}
+
+	bool	   storage_;
+	GLuint	   buffer_	 = 0;
+	GLsizeiptr stride_	 = kPaletteBytes;	// bytes between two palettes
+	GLsizeiptr capacity_ = 0;
+	size_t	   count_	 = 0;				// palettes in the buffer
+};
+
+#endif // !__BONE_PALETTE_H
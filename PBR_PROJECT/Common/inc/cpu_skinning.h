@@ -0,0 +1,182 @@
+#ifndef __CPU_SKINNING_H
+#define __CPU_SKINNING_H
+
+#include "custom_macro.h"
+#include "simd_float.h"
+#include "thread_pool.h"
+#include "vertex_format.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <vector>
+
+// bind pose vertex as the skinning loop reads it, one cache line each. Influences without a bone
+// (id -1) are stored as bone 0 with weight 0, so every vertex blends exactly four matrices
+struct SkinningVertex {
+	glm::vec4  pos;		// w = 1
+	glm::vec4  norm;	// w = 0
+	glm::ivec4 bones;
+	glm::vec4  weights;
+};
+static_assert(sizeof(SkinningVertex) == 64, "SkinningVertex should fill one cache line");
+
+// Skins vertices on the CPU with the same rule as skelanim.vert: the weighted sum of the palette
+// matrices of the vertex's bones, the bind pose when one bone is outside the palette. Positions and
+// normals come out in model space for picking, bounds, collision or export, without a GL context.
+//
+// Each vertex blends its four matrices into one and transforms position and normal with that, two
+// columns per AVX register (four SSE ones, or glm without either). Ranges of kChunkSize vertices are
+// spread over a thread pool.
+class CpuSkinning {
+	NoConstructor(CpuSkinning)
+public:
+	static constexpr size_t kChunkSize = 4096;
+
+	static std::vector<SkinningVertex> Prepare(std::span<const Vertex> vertices) {
+		std::vector<SkinningVertex> result;
+		result.reserve(vertices.size());
+		for (const Vertex& vertex : vertices) {
+			SkinningVertex& out = result.emplace_back();
+			out.pos	 = glm::vec4(vertex.pos, 1.0f);
+			out.norm = glm::vec4(vertex.norm, 0.0f);
+			for (int i = 0; i < MAX_BONE_INFLUENCE; ++i) {
+				bool bound = vertex.m_BoneIDs[i] >= 0;
+				out.bones[i]   = bound ? vertex.m_BoneIDs[i] : 0;
+				out.weights[i] = bound ? vertex.m_Weights[i] : 0.0f;
+			}
+		}
+		return result;
+	}
+
+	// skins vertices with palette into positions and normals (may be empty to skip them), both at least
+	// vertices.size() long. max_threads limits the threads taking part, the caller included, 0 for all
+	static void Skin(std::span<const SkinningVertex> vertices, std::span<const glm::mat4> palette,
+		std::span<glm::vec3> positions, std::span<glm::vec3> normals, size_t max_threads = 0, ThreadPool& pool = ThreadPool::Global())
+	{
+		size_t chunks = (vertices.size() + kChunkSize - 1) / kChunkSize;
+		pool.ParallelFor(chunks, [&](size_t chunk) {
+			size_t begin = chunk * kChunkSize;
+			size_t end	 = std::min(vertices.size(), begin + kChunkSize);
+			SkinRange(vertices.subspan(begin, end - begin), palette,
+				positions.empty() ? positions : positions.subspan(begin, end - begin),
+				normals.empty() ? normals : normals.subspan(begin, end - begin));
+		}, max_threads);
+	}
+
+	// Skin on the calling thread
+	static void SkinRange(std::span<const SkinningVertex> vertices, std::span<const glm::mat4> palette,
+		std::span<glm::vec3> positions, std::span<glm::vec3> normals)
+	{
+		const int bone_count = static_cast<int>(palette.size());
+		const float* matrices = reinterpret_cast<const float*>(palette.data());
+		for (size_t v = 0; v < vertices.size(); ++v) {
+			const SkinningVertex& vertex = vertices[v];
+			const glm::ivec4& bones = vertex.bones;
+			if (bones.x >= bone_count || bones.y >= bone_count || bones.z >= bone_count || bones.w >= bone_count) {
+				if (!positions.empty()) positions[v] = glm::vec3(vertex.pos);
+				if (!normals.empty())	normals[v]	 = glm::vec3(vertex.norm);
+				continue;
+			}
+			alignas(16) float pos[4], norm[4];
+			BlendAndTransform(matrices, vertex, pos, norm);
+			if (!positions.empty()) positions[v] = glm::vec3(pos[0], pos[1], pos[2]);
+			if (!normals.empty()) {
+				float len = std::sqrt(norm[0] * norm[0] + norm[1] * norm[1] + norm[2] * norm[2]);
+				normals[v] = len > 0.0f ? glm::vec3(norm[0], norm[1], norm[2]) / len : glm::vec3(0.0f);
+			}
+		}
+	}
+
+	// line by line port of skelanim.vert working on the imported vertices, what the fast path is checked
+	// against. The normal gets the same weighted sum as the position, as in the shader
+	static void SkinReference(std::span<const Vertex> vertices, std::span<const glm::mat4> palette,
+		std::span<glm::vec3> positions, std::span<glm::vec3> normals)
+	{
+		const int max_bones = static_cast<int>(palette.size());
+		for (size_t v = 0; v < vertices.size(); ++v) {
+			const Vertex& vertex = vertices[v];
+			glm::vec4 pos_sum  = glm::vec4(0.0f);
+			glm::vec3 norm_sum = glm::vec3(0.0f);
+			for (int i = 0; i < MAX_BONE_INFLUENCE; i++) {
+				if (vertex.m_BoneIDs[i] == -1)
+					continue;
+				if (vertex.m_BoneIDs[i] >= max_bones) {
+					pos_sum	 = glm::vec4(vertex.pos, 1.0f);
+					norm_sum = vertex.norm;
+					break;
+				}
+				pos_sum	 += palette[vertex.m_BoneIDs[i]] * glm::vec4(vertex.pos, 1.0f) * vertex.m_Weights[i];
+				norm_sum += glm::mat3(palette[vertex.m_BoneIDs[i]]) * vertex.norm * vertex.m_Weights[i];
+			}
+			if (!positions.empty()) positions[v] = glm::vec3(pos_sum);
+			if (!normals.empty()) {
+				float len = glm::length(norm_sum);
+				normals[v] = len > 0.0f ? norm_sum / len : glm::vec3(0.0f);
+			}
+		}
+	}
+
+private:
+	// pos = (sum of weights[i] * palette[bones[i]]) * vertex.pos, norm the same with vertex.norm
+	static void BlendAndTransform(const float* matrices, const SkinningVertex& vertex, float* pos, float* norm) {
+#if defined(SIMD_FLOAT_AVX)
+		// blended matrix, lo holds columns 0 and 1, hi columns 2 and 3
+		__m256 lo = _mm256_setzero_ps(), hi = _mm256_setzero_ps();
+		for (int i = 0; i < MAX_BONE_INFLUENCE; ++i) {
+			const float* m = matrices + vertex.bones[i] * 16;
+			__m256 w = _mm256_set1_ps(vertex.weights[i]);
+			lo = MulAdd(w, _mm256_loadu_ps(m), lo);
+			hi = MulAdd(w, _mm256_loadu_ps(m + 8), hi);
+		}
+		auto transform = [&](const glm::vec4& p, float* out) {
+			__m256 xy = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(p.x)), _mm_set1_ps(p.y), 1);
+			__m256 zw = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(p.z)), _mm_set1_ps(p.w), 1);
+			__m256 sum = MulAdd(lo, xy, _mm256_mul_ps(hi, zw));
+			_mm_store_ps(out, _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)));
+		};
+		transform(vertex.pos, pos);
+		transform(vertex.norm, norm);
+#elif defined(SIMD_FLOAT_SSE)
+		__m128 col[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps() };
+		for (int i = 0; i < MAX_BONE_INFLUENCE; ++i) {
+			const float* m = matrices + vertex.bones[i] * 16;
+			__m128 w = _mm_set1_ps(vertex.weights[i]);
+			for (int c = 0; c < 4; ++c) col[c] = _mm_add_ps(col[c], _mm_mul_ps(w, _mm_loadu_ps(m + c * 4)));
+		}
+		auto transform = [&](const glm::vec4& p, float* out) {
+			__m128 sum = _mm_mul_ps(col[0], _mm_set1_ps(p.x));
+			sum = _mm_add_ps(sum, _mm_mul_ps(col[1], _mm_set1_ps(p.y)));
+			sum = _mm_add_ps(sum, _mm_mul_ps(col[2], _mm_set1_ps(p.z)));
+			sum = _mm_add_ps(sum, _mm_mul_ps(col[3], _mm_set1_ps(p.w)));
+			_mm_store_ps(out, sum);
+		};
+		transform(vertex.pos, pos);
+		transform(vertex.norm, norm);
+#else
+		glm::mat4 blended(0.0f);
+		for (int i = 0; i < MAX_BONE_INFLUENCE; ++i) {
+			const float* m = matrices + vertex.bones[i] * 16;
+			for (int c = 0; c < 4; ++c)
+				blended[c] += glm::vec4(m[c * 4], m[c * 4 + 1], m[c * 4 + 2], m[c * 4 + 3]) * vertex.weights[i];
+		}
+		glm::vec4 p = blended * vertex.pos, n = blended * vertex.norm;
+		for (int c = 0; c < 4; ++c) { pos[c] = p[c]; norm[c] = n[c]; }
+#endif
+	}
+
+#if defined(SIMD_FLOAT_AVX)
+	// a * b + c, fused where the build targets FMA (MSVC has no macro for it, /arch:AVX2 implies it)
+	static __m256 MulAdd(__m256 a, __m256 b, __m256 c) {
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(__AVX2__))
+		return _mm256_fmadd_ps(a, b, c);
+#else
+		return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+	}
+#endif
+};
+
+#endif // !__CPU_SKINNING_H
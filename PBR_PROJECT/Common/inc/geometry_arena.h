@@ -0,0 +1,128 @@
+#ifndef __GEOMETRY_ARENA_H
+#define __GEOMETRY_ARENA_H
+
+#include "gl_state.h"
+#include "vertex_format.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// where a mesh lives inside a GeometryArena
+struct GeometryRange {
+	int			 base_vertex  = 0;
+	unsigned int vertex_count = 0;
+	unsigned int first_index  = 0;
+	unsigned int index_count  = 0;
+};
+
+// layout consumed by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+	GLuint count;
+	GLuint instance_count;
+	GLuint first_index;
+	GLint  base_vertex;
+	GLuint base_instance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "indirect command layout is fixed by GL");
+
+// one VAO + VBO + EBO holding the geometry of many meshes of the same vertex layout.
+// Indices stay local to their mesh and are rebased at draw time through base vertex,
+// so binding the arena once is enough to draw everything it holds.
+// Allocations are append only, the arena is meant for assets that live as long as the program.
+class GeometryArena {
+public:
+	explicit GeometryArena(VertexFormat format) : format_(format) {
+		glGenVertexArrays(1, &vao_);
+		glGenBuffers(1, &vbo_);
+		glGenBuffers(1, &ebo_);
+	}
+
+	~GeometryArena() {
+		glDeleteBuffers(1, &ebo_);
+		glDeleteBuffers(1, &vbo_);
+		GLState::ForgetVertexArray(vao_);
+		glDeleteVertexArrays(1, &vao_);
+	}
+
+	GeometryArena(const GeometryArena&)			   = delete;
+	GeometryArena& operator=(const GeometryArena&) = delete;
+
+	// appends a mesh, vertices are encoded to the arena layout
+	GeometryRange Allocate(std::span<const Vertex> vertices, std::span<const unsigned int> indices) {
+		GeometryRange range;
+		range.base_vertex  = static_cast<int>(vertex_count_);
+		range.vertex_count = static_cast<unsigned int>(vertices.size());
+		range.first_index  = static_cast<unsigned int>(index_count_);
+		range.index_count  = static_cast<unsigned int>(indices.size());
+
+		size_t stride = VertexFormatStride(format_);
+
+		GLState::BindVertexArray(vao_);
+		Reserve(GL_ARRAY_BUFFER, vbo_, vbo_capacity_, vertex_count_ * stride, vertices.size() * stride);
+		UploadVertices(GL_ARRAY_BUFFER, vertex_count_ * stride, format_, vertices);
+		Reserve(GL_ELEMENT_ARRAY_BUFFER, ebo_, ebo_capacity_, index_count_ * sizeof(unsigned int), indices.size_bytes());
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, index_count_ * sizeof(unsigned int), indices.size_bytes(), indices.data());
+		GLState::BindVertexArray(0);
+
+		vertex_count_ += vertices.size();
+		index_count_  += indices.size();
+		return range;
+	}
+
+	inline void			Bind()		  const { GLState::BindVertexArray(vao_); }
+	inline unsigned int VAO()		  const { return vao_; }
+	inline VertexFormat Format()	  const { return format_; }
+	inline size_t		VertexCount() const { return vertex_count_; }
+	inline size_t		IndexCount()  const { return index_count_; }
+
+	// one arena per vertex layout shared by every model, created on first use from the GL thread.
+	// They are never destroyed, the context is usually gone before static destructors run.
+	static GeometryArena& Shared(VertexFormat format) {
+		static std::array<GeometryArena*, 3> arenas{};
+		GeometryArena*& arena = arenas[static_cast<size_t>(format)];
+		if (!arena) arena = new GeometryArena(format);
+		return *arena;
+	}
+
+private:
+	// makes room for `size` more bytes after `used`, growing geometrically and copying on the GPU.
+	// expects the VAO bound so the replacement buffer is re-attached to it
+	void Reserve(GLenum target, unsigned int& buffer, size_t& capacity, size_t used, size_t size) {
+		if (used + size <= capacity) {
+			glBindBuffer(target, buffer);
+			return;
+		}
+		size_t new_capacity = std::max(used + size, capacity * 2);
+		unsigned int new_buffer;
+		glGenBuffers(1, &new_buffer);
+		glBindBuffer(target, new_buffer);
+		glBufferData(target, new_capacity, nullptr, GL_STATIC_DRAW);
+		if (used > 0) {
+			glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, target, 0, 0, used);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &buffer);
+		buffer	 = new_buffer;
+		capacity = new_capacity;
+		// the element buffer binding is VAO state already, attribute pointers latch the array buffer
+		if (target == GL_ARRAY_BUFFER) SetupVertexAttributes(format_);
+	}
+
+private:
+	VertexFormat format_;
+	unsigned int vao_			= 0;
+	unsigned int vbo_			= 0;
+	unsigned int ebo_			= 0;
+	size_t		 vbo_capacity_	= 0;
+	size_t		 ebo_capacity_	= 0;
+	size_t		 vertex_count_	= 0;
+	size_t		 index_count_	= 0;
+};
+
+#endif // !__GEOMETRY_ARENA_H
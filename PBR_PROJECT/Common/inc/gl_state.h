@@ -0,0 +1,187 @@
+#ifndef __GL_STATE_H
+#define __GL_STATE_H
+
+#include "custom_macro.h"
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstdint>
+
+// Shadow copy of the GL state the render loops touch: program, VAO, draw framebuffer, texture bindings
+// per unit and target, the depth/blend/cull switches and functions. A call that would set what is
+// already set is dropped and counted, so the counters show how much driver work a frame avoided.
+//
+// Anything that changes this state behind the cache's back (raw GL in resource creation, foreign code)
+// must be followed by Invalidate, otherwise a later call may be skipped wrongly. Deleting an object
+// that may be bound goes through the Forget* functions, GL unbinds deleted names by itself.
+class GLState {
+
+	NoConstructor(GLState)
+
+public:
+	static constexpr GLuint kUnknown		 = ~0u;
+	static constexpr GLuint kMaxTextureUnits = 32;
+
+	struct Counters {
+		uint64_t issued;	// calls that reached GL
+		uint64_t skipped;	// redundant calls dropped
+	};
+
+	static void UseProgram(GLuint program) {
+		if (Redundant(program_ == program)) return;
+		program_ = program;
+		glUseProgram(program);
+	}
+
+	static void BindVertexArray(GLuint vao) {
+		if (Redundant(vao_ == vao)) return;
+		vao_ = vao;
+		glBindVertexArray(vao);
+	}
+
+	// binds both the draw and the read framebuffer, like glBindFramebuffer(GL_FRAMEBUFFER, ...)
+	static void BindFramebuffer(GLuint fbo) {
+		if (Redundant(framebuffer_ == fbo)) return;
+		framebuffer_ = fbo;
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	}
+
+	static void ActiveTexture(GLuint unit) {
+		if (Redundant(active_unit_ == unit)) return;
+		active_unit_ = unit;
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+
+	static void BindTexture(GLuint unit, GLenum target, GLuint texture) {
+		int slot = TargetSlot(target);
+		if (slot < 0 || unit >= kMaxTextureUnits) {
+			ActiveTexture(unit);
+			Redundant(false);
+			glBindTexture(target, texture);
+			return;
+		}
+		GLuint& bound = textures_[unit][slot];
+		if (Redundant(bound == texture)) return;
+		ActiveTexture(unit);
+		bound = texture;
+		glBindTexture(target, texture);
+	}
+
+	static void SetEnabled(GLenum cap, bool enabled) {
+		int slot = CapSlot(cap);
+		GLuint state = enabled ? 1 : 0;
+		if (slot >= 0) {
+			if (Redundant(caps_[slot] == state)) return;
+			caps_[slot] = state;
+		}
+		else {
+			Redundant(false);
+		}
+		enabled ? glEnable(cap) : glDisable(cap);
+	}
+
+	static void Enable(GLenum cap)	{ SetEnabled(cap, true); }
+	static void Disable(GLenum cap) { SetEnabled(cap, false); }
+
+	static void DepthFunc(GLenum func) {
+		if (Redundant(depth_func_ == func)) return;
+		depth_func_ = func;
+		glDepthFunc(func);
+	}
+
+	static void DepthMask(bool write) {
+		GLuint state = write ? 1 : 0;
+		if (Redundant(depth_mask_ == state)) return;
+		depth_mask_ = state;
+		glDepthMask(write ? GL_TRUE : GL_FALSE);
+	}
+
+	static void BlendFunc(GLenum src, GLenum dst) {
+		if (Redundant(blend_src_ == src && blend_dst_ == dst)) return;
+		blend_src_ = src;
+		blend_dst_ = dst;
+		glBlendFunc(src, dst);
+	}
+
+	static void CullFace(GLenum mode) {
+		if (Redundant(cull_face_ == mode)) return;
+		cull_face_ = mode;
+		glCullFace(mode);
+	}
+
+	// forget everything, the next call of each kind reaches GL again
+	static void Invalidate() {
+		program_ = vao_ = framebuffer_ = active_unit_ = kUnknown;
+		depth_func_ = depth_mask_ = blend_src_ = blend_dst_ = cull_face_ = kUnknown;
+		caps_.fill(kUnknown);
+		for (auto& unit : textures_) unit.fill(kUnknown);
+	}
+
+	// call after deleting objects, GL has reset the bindings that referred to them
+	static void ForgetTexture(GLuint texture) {
+		for (auto& unit : textures_)
+			for (GLuint& bound : unit)
+				if (bound == texture) bound = 0;
+	}
+	static void ForgetVertexArray(GLuint vao)	 { if (vao_ == vao) vao_ = 0; }
+	static void ForgetFramebuffer(GLuint fbo)	 { if (framebuffer_ == fbo) framebuffer_ = 0; }
+	// a deleted program stays in use until another one is, the name may be handed out again before that
+	static void ForgetProgram(GLuint program)	 { if (program_ == program) program_ = kUnknown; }
+
+	// counters since the last EndFrame
+	static const Counters& Frame()	   { return frame_; }
+	// counters of the last completed frame
+	static const Counters& LastFrame() { return last_frame_; }
+
+	static void EndFrame() {
+		last_frame_ = frame_;
+		frame_		= {};
+	}
+
+private:
+	static bool Redundant(bool redundant) {
+		redundant ? ++frame_.skipped : ++frame_.issued;
+		return redundant;
+	}
+
+	static int TargetSlot(GLenum target) {
+		switch (target) {
+		case GL_TEXTURE_2D:		  return 0;
+		case GL_TEXTURE_CUBE_MAP: return 1;
+		case GL_TEXTURE_2D_ARRAY: return 2;
+		case GL_TEXTURE_BUFFER:	  return 3;
+		default:				  return -1;
+		}
+	}
+
+	static int CapSlot(GLenum cap) {
+		switch (cap) {
+		case GL_DEPTH_TEST: return 0;
+		case GL_BLEND:		return 1;
+		case GL_CULL_FACE:	return 2;
+		default:			return -1;
+		}
+	}
+
+	static inline GLuint program_	  = kUnknown;
+	static inline GLuint vao_		  = kUnknown;
+	static inline GLuint framebuffer_ = kUnknown;
+	static inline GLuint active_unit_ = kUnknown;
+	static inline GLuint depth_func_  = kUnknown;
+	static inline GLuint depth_mask_  = kUnknown;
+	static inline GLuint blend_src_	  = kUnknown;
+	static inline GLuint blend_dst_	  = kUnknown;
+	static inline GLuint cull_face_	  = kUnknown;
+	static inline std::array<GLuint, 3> caps_ = { kUnknown, kUnknown, kUnknown };
+	static inline std::array<std::array<GLuint, 4>, kMaxTextureUnits> textures_ = [] {
+		std::array<std::array<GLuint, 4>, kMaxTextureUnits> units;
+		for (auto& unit : units) unit.fill(kUnknown);
+		return units;
+	}();
+
+	static inline Counters frame_	   = {};
+	static inline Counters last_frame_ = {};
+};
+
+#endif // !__GL_STATE_H
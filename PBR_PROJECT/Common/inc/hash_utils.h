@@ -0,0 +1,34 @@
+#ifndef __HASH_UTILS_H
+#define __HASH_UTILS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+// 64-bit FNV-1a, good enough to key on-disk caches by content
+constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime	   = 1099511628211ull;
+
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = kFnvOffsetBasis)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= kFnvPrime;
+	}
+	return hash;
+}
+
+inline uint64_t HashString(std::string_view str, uint64_t seed = kFnvOffsetBasis)
+{
+	return HashBytes(str.data(), str.size(), seed);
+}
+
+template<class T>
+inline uint64_t HashValue(const T& val, uint64_t seed = kFnvOffsetBasis)
+{
+	return HashBytes(&val, sizeof(T), seed);
+}
+
+#endif // !__HASH_UTILS_H
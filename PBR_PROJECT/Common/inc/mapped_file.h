@@ -0,0 +1,36 @@
+#ifndef __MAPPED_FILE_H
+#define __MAPPED_FILE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// read-only memory mapping of a whole file, unmapped on destruction
+class MappedFile {
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string& path) { Open(path); }
+	~MappedFile() { Close(); }
+
+	MappedFile(const MappedFile&)			 = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+
+	inline bool			  IsOpen() const { return data_ != nullptr; }
+	inline const uint8_t* Data()   const { return data_; }
+	inline size_t		  Size()   const { return size_; }
+
+private:
+	const uint8_t* data_	   = nullptr;
+	size_t		   size_	   = 0;
+#ifdef _WIN32
+	void*		   file_	   = nullptr;
+	void*		   mapping_	   = nullptr;
+#else
+	int			   fd_		   = -1;
+#endif
+};
+
+#endif // !__MAPPED_FILE_H
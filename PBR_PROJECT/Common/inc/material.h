@@ -0,0 +1,164 @@
+#ifndef __MATERIAL_H
+#define __MATERIAL_H
+
+#include "gl_state.h"
+#include "shader.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct Texture {
+	unsigned int id;
+	std::string	 type;
+	std::string	 path;
+};
+
+// The textures of a mesh and the sampler each one feeds ("texture_diffuse1", "texture_normal2", ...).
+// Sampler names are built when the material is created; the first Bind with a program resolves them to
+// texture units once and keeps the (unit, texture) pairs, so later binds are a handful of glBindTexture
+// calls without string work, uniform calls or allocations.
+//
+// Units are handed out per program, not per material: when the first material is bound with a program
+// every texture_* sampler it declares gets a unit of its own. The uniforms are written once for the life
+// of the program, materials that share a texture also share its binding, and samplers of different types
+// (sampler2D, sampler2DArray) never end up on the same unit.
+//
+// Both are keyed by Shader::serial(); entries of programs that were reloaded or destroyed are dropped on
+// the next bind after Shader::retiredCount() changed.
+class Material {
+public:
+	Material() = default;
+
+	// textures need their ids resolved, the N in texture_<type>N counts up per type in the order given.
+	// Other types are used as the sampler name as they are, e.g. "texture_diffuse_array"
+	explicit Material(const std::vector<Texture>& textures, GLenum target = GL_TEXTURE_2D) {
+		unsigned int diffuse_nr = 1, specular_nr = 1, normal_nr = 1, height_nr = 1;
+		samplers_.reserve(textures.size());
+		for (const Texture& texture : textures) {
+			std::string name = texture.type;
+			if		(name == "texture_diffuse")	 name += std::to_string(diffuse_nr++);
+			else if (name == "texture_specular") name += std::to_string(specular_nr++);
+			else if (name == "texture_normal")	 name += std::to_string(normal_nr++);
+			else if (name == "texture_height")	 name += std::to_string(height_nr++);
+			samplers_.push_back({ texture.id, target, std::move(name) });
+		}
+	}
+
+	// binds every texture the program samples; shader has to be in use the first time it is seen
+	void Bind(const Shader& shader) {
+		if (samplers_.empty()) return;
+		const ProgramBindings& program = Resolve(shader);
+		for (const TextureBinding& binding : program.bindings)
+			GLState::BindTexture(binding.unit, binding.target, binding.texture);
+	}
+
+	// same textures feeding the same samplers, such materials can share a draw
+	bool SameTextures(const Material& other) const {
+		return std::equal(samplers_.begin(), samplers_.end(), other.samplers_.begin(), other.samplers_.end(),
+			[](const Sampler& a, const Sampler& b) { return a.texture == b.texture && a.target == b.target && a.name == b.name; });
+	}
+
+	inline bool	  Empty() const { return samplers_.empty(); }
+	inline size_t Size()  const { return samplers_.size(); }
+
+private:
+	struct Sampler {
+		GLuint		texture;
+		GLenum		target;
+		std::string name;
+	};
+
+	struct TextureBinding {
+		GLuint unit;
+		GLenum target;
+		GLuint texture;
+	};
+
+	struct ProgramBindings {
+		uint64_t					program;	// Shader::serial() the bindings were resolved for
+		std::vector<TextureBinding> bindings;
+	};
+
+	// sampler name -> unit of one program
+	using ProgramUnits = std::unordered_map<std::string, GLuint>;
+
+	const ProgramBindings& Resolve(const Shader& shader) {
+		if (retired_seen_ != Shader::retiredCount()) {
+			retired_seen_ = Shader::retiredCount();
+			std::erase_if(programs_, [](const ProgramBindings& program) { return !Shader::isLive(program.program); });
+			last_ = 0;
+		}
+		uint64_t serial = shader.serial();
+		if (last_ < programs_.size() && programs_[last_].program == serial)
+			return programs_[last_];
+		for (last_ = 0; last_ < programs_.size(); ++last_)
+			if (programs_[last_].program == serial)
+				return programs_[last_];
+
+		// first bind with this program, samplers it does not use (optimized out) get no binding
+		ProgramBindings program{ serial, {} };
+		const ProgramUnits& units = Units(shader);
+		for (const Sampler& sampler : samplers_) {
+			auto iter = units.find(sampler.name);
+			if (iter != units.end())
+				program.bindings.push_back({ iter->second, sampler.target, sampler.texture });
+		}
+		programs_.push_back(std::move(program));
+		return programs_[last_];
+	}
+
+	// unit assignment shared by every material drawn with the program, made on its first bind.
+	// Units follow the sampler names in sorted order so they do not depend on which material came first
+	static const ProgramUnits& Units(const Shader& shader) {
+		static std::unordered_map<uint64_t, ProgramUnits> programs;
+		static uint64_t retired_seen = 0;
+		if (retired_seen != Shader::retiredCount()) {
+			retired_seen = Shader::retiredCount();
+			std::erase_if(programs, [](const auto& entry) { return !Shader::isLive(entry.first); });
+		}
+		auto [iter, inserted] = programs.try_emplace(shader.serial());
+		if (!inserted) return iter->second;
+
+		std::vector<std::pair<std::string_view, GLint>> samplers;
+		shader.forEachUniform([&](std::string_view name, const Shader::UniformInfo& info) {
+			if (name.starts_with("texture_") && name.find('[') == std::string_view::npos && IsSampler(info.type))
+				samplers.emplace_back(name, info.location);
+		});
+		std::sort(samplers.begin(), samplers.end());
+		for (const auto& [name, location] : samplers) {
+			GLuint unit = static_cast<GLuint>(iter->second.size());
+			iter->second.emplace(std::string(name), unit);
+			glUniform1i(location, static_cast<GLint>(unit));
+		}
+		return iter->second;
+	}
+
+	static bool IsSampler(GLenum type) {
+		switch (type) {
+		case GL_SAMPLER_2D:
+		case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_BUFFER:
+		case GL_INT_SAMPLER_BUFFER:
+		case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+private:
+	std::vector<Sampler>		 samplers_;
+	std::vector<ProgramBindings> programs_;
+	size_t						 last_ = 0;	// index into programs_ of the last bind
+	uint64_t					 retired_seen_ = 0;	// Shader::retiredCount() when programs_ was last pruned
+};
+
+#endif // !__MATERIAL_H
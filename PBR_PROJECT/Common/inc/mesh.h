@@ -1,39 +1,64 @@
 #ifndef MESH_H
 #define MESH_H
 #include "shader.h"
+#include "material.h"
+#include "cpu_skinning.h"
+#include "vertex_format.h"
+#include "geometry_arena.h"
+#include "gl_state.h"
 
 #include <glad/glad.h> // holds all OpenGL type declarations
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 using namespace std;
 
-#define MAX_BONE_INFLUENCE 4
-
-struct Vertex {
-    // position
-    glm::vec3 pos;
-    // normal
-    glm::vec3 norm;
-    // texCoords
-    glm::vec2 uv;
-    // tangent
-    glm::vec3 tang;
-    // bitangent
-    glm::vec3 bitang;
-    //bone indexes which will influence this vertex
-    int m_BoneIDs[MAX_BONE_INFLUENCE];
-    //weights from each bone
-    float m_Weights[MAX_BONE_INFLUENCE];
+// a level of detail is a range of the mesh's index buffer, all levels share the vertices
+constexpr size_t kMaxMeshLods = 4;
+
+struct MeshLod {
+    unsigned int first_index;
+    unsigned int index_count;
+    float        error;         // object space deviation from the base mesh
+};
+
+// what LOD selection needs to know about the view
+struct LodView {
+    glm::mat4 model;                // model to world
+    glm::vec3 camera_pos;
+    float     fovy;                 // vertical field of view in radians
+    float     viewport_height;      // in pixels
+    float     pixel_error = 1.0f;   // tolerated screen space error
 };
 
-struct Texture {
-    unsigned int id;
-    string type;
-    string path;
+// what a Mesh keeps in system memory once its buffers are uploaded
+enum class MeshResidency {
+    eKeep,          // vertices and indices stay
+    eDrop,          // nothing, the GPU copy is the only one
+    ePositions,     // positions and base LOD indices, enough for picking and culling
+    eSkinning       // bind pose for CpuSkinning and base LOD indices, to pick or export the animated mesh
+};
+
+// CPU side result of an import, may be produced on any thread and becomes a Mesh on the GL thread.
+// Texture ids stay 0 until then, only type and path are known.
+struct MeshData {
+    vector<Vertex>       vertices;
+    vector<unsigned int> indices;
+    vector<Texture>      textures;
+    vector<MeshLod>      lods;
+    // a warm start leaves vertices and indices empty and points into the mapped mesh cache instead,
+    // mapping keeps the file mapped until the Mesh is uploaded from it
+    span<const Vertex>       mapped_vertices;
+    span<const unsigned int> mapped_indices;
+    std::shared_ptr<const void> mapping;
 };
 
 class Mesh {
@@ -42,104 +67,221 @@ public:
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
     vector<Texture>      textures;
+    Material             material;     // samplers of textures, what Draw binds
     unsigned int VAO;
+    VertexFormat format;
+    // set when the geometry lives in a shared GeometryArena instead of buffers of its own
+    GeometryArena* arena = nullptr;
+    GeometryRange  range;
+    // lods[0] is the full mesh, coarser levels follow its indices
+    vector<MeshLod> lods;
+    glm::vec3       bounds_center = glm::vec3(0.0f);
+    float           bounds_radius = 0.0f;
+    // sizes as uploaded, valid whatever the residency
+    unsigned int      vertex_count = 0;
+    unsigned int      index_count  = 0;
+    MeshResidency     residency    = MeshResidency::eKeep;
+    vector<glm::vec3> positions;    // only filled for MeshResidency::ePositions
+    vector<SkinningVertex> skinning;    // only filled for MeshResidency::eSkinning
 
     // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, VertexFormat format = VertexFormat::eFull, bool shared_arena = false,
+        vector<MeshLod> lods = {})
+        : format(format)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
+        this->lods = std::move(lods);
+        material = Material(this->textures);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(this->vertices, this->indices, shared_arena);
     }
 
-    // render the mesh
-    void Draw(Shader& shader)
+    // constructor from already processed data, e.g. spans into a mapped mesh cache. The buffers are
+    // filled straight from the spans, system memory only gets the copy residency keeps
+    Mesh(span<const Vertex> vertices, span<const unsigned int> indices, vector<Texture> textures, VertexFormat format = VertexFormat::eFull, bool shared_arena = false,
+        vector<MeshLod> lods = {}, MeshResidency residency = MeshResidency::eKeep)
+        : textures(std::move(textures)),
+          material(this->textures),
+          format(format),
+          lods(std::move(lods))
+    {
+        setupMesh(vertices, indices, shared_arena);
+        keepResident(vertices, indices, residency);
+    }
+
+    // takes over imported data, textures must already be resolved. Data mapped from the mesh cache is
+    // uploaded as the span constructor does
+    Mesh(MeshData&& data, VertexFormat format = VertexFormat::eFull, bool shared_arena = false, MeshResidency residency = MeshResidency::eKeep)
+        : textures(std::move(data.textures)),
+          material(this->textures),
+          format(format),
+          lods(std::move(data.lods))
     {
-        // bind appropriate textures
-        unsigned int diffuseNr = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr = 1;
-        unsigned int heightNr = 1;
-        for (unsigned int i = 0; i < textures.size(); i++)
+        if (data.mapping)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if (name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if (name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to string
-            else if (name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to string
-            else if (name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to string
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            setupMesh(data.mapped_vertices, data.mapped_indices, shared_arena);
+            keepResident(data.mapped_vertices, data.mapped_indices, residency);
+            return;
         }
+        vertices = std::move(data.vertices);
+        indices = std::move(data.indices);
+        setupMesh(vertices, indices, shared_arena);
+        ApplyResidency(residency);
+    }
+
+    // render the mesh
+    void Draw(Shader& shader, size_t lod = 0)
+    {
+        material.Bind(shader);
+
+        // draw mesh, the bindings stay for the next draw to reuse (see GLState)
+        const MeshLod& level = lods[lod];
+        GLState::BindVertexArray(VAO);
+        if (arena)
+            glDrawElementsBaseVertex(GL_TRIANGLES, level.index_count, GL_UNSIGNED_INT,
+                (void*)((range.first_index + level.first_index) * sizeof(unsigned int)), range.base_vertex);
+        else
+            glDrawElements(GL_TRIANGLES, level.index_count, GL_UNSIGNED_INT, (void*)(level.first_index * sizeof(unsigned int)));
+    }
+
+    // coarsest level whose error projects to at most view.pixel_error pixels
+    size_t SelectLod(const LodView& view) const
+    {
+        if (lods.size() < 2)
+            return 0;
+        float scale = std::max({ glm::length(glm::vec3(view.model[0])), glm::length(glm::vec3(view.model[1])), glm::length(glm::vec3(view.model[2])) });
+        glm::vec3 center = glm::vec3(view.model * glm::vec4(bounds_center, 1.0f));
+        float distance = std::max(glm::length(center - view.camera_pos) - bounds_radius * scale, 1e-3f);
+        float pixels_per_unit = view.viewport_height / (2.0f * distance * std::tan(view.fovy * 0.5f));
+        size_t lod = 0;
+        while (lod + 1 < lods.size() && lods[lod + 1].error * scale * pixels_per_unit <= view.pixel_error)
+            ++lod;
+        return lod;
+    }
+
+    size_t VertexStride() const
+    {
+        return VertexFormatStride(format);
+    }
+
+    // releases CPU geometry the policy does not keep, only ever gives memory back
+    void ApplyResidency(MeshResidency policy)
+    {
+        if (policy == MeshResidency::eKeep || residency != MeshResidency::eKeep)
+            return;
+        vector<Vertex> uploaded_vertices;
+        vector<unsigned int> uploaded_indices;
+        uploaded_vertices.swap(vertices);
+        uploaded_indices.swap(indices);
+        keepResident(uploaded_vertices, uploaded_indices, policy);
+    }
 
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    size_t CpuBytes() const
+    {
+        return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int)
+            + positions.capacity() * sizeof(glm::vec3) + skinning.capacity() * sizeof(SkinningVertex)
+            + lods.capacity() * sizeof(MeshLod);
+    }
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+    size_t GpuBytes() const
+    {
+        return static_cast<size_t>(vertex_count) * VertexStride() + static_cast<size_t>(index_count) * sizeof(unsigned int);
     }
 
 private:
     // render data 
-    unsigned int VBO, EBO;
+    unsigned int VBO = 0, EBO = 0;
+
+    // fills what policy keeps in system memory from the uploaded geometry, which the mesh does not hold yet
+    void keepResident(span<const Vertex> vertices, span<const unsigned int> indices, MeshResidency policy)
+    {
+        span<const unsigned int> base_indices = indices.first(lods[0].index_count);
+        if (policy == MeshResidency::eKeep)
+        {
+            this->vertices.assign(vertices.begin(), vertices.end());
+            this->indices.assign(indices.begin(), indices.end());
+        }
+        else if (policy == MeshResidency::ePositions)
+        {
+            positions.reserve(vertices.size());
+            for (const Vertex& vertex : vertices)
+                positions.push_back(vertex.pos);
+            this->indices.assign(base_indices.begin(), base_indices.end());
+        }
+        else if (policy == MeshResidency::eSkinning)
+        {
+            skinning = CpuSkinning::Prepare(vertices);
+            this->indices.assign(base_indices.begin(), base_indices.end());
+        }
+        residency = policy;
+    }
 
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(span<const Vertex> vertices, span<const unsigned int> indices, bool shared_arena)
     {
+        format = ResolveVertexFormat(format, vertices);
+        if (lods.empty())
+            lods.push_back({ 0, static_cast<unsigned int>(indices.size()), 0.0f });
+        vertex_count = static_cast<unsigned int>(vertices.size());
+        index_count  = static_cast<unsigned int>(indices.size());
+        computeBounds(vertices);
+
+        if (shared_arena)
+        {
+            arena = &GeometryArena::Shared(format);
+            range = arena->Allocate(vertices, indices);
+            VAO = arena->VAO();
+            return;
+        }
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
 
-        glBindVertexArray(VAO);
+        GLState::BindVertexArray(VAO);
         // load data into vertex buffers
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        if (format == VertexFormat::eFull)
+        {
+            // A great thing about structs is that their memory layout is sequential for all its items.
+            // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
+            // again translates to 3/2 floats which translates to a byte array.
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+        }
+        else
+        {
+            // packed layouts are encoded straight into the buffer storage
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * VertexStride(), nullptr, GL_STATIC_DRAW);
+            UploadVertices(GL_ARRAY_BUFFER, 0, format, vertices);
+        }
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
         // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, norm));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, uv));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tang));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, bitang));
-        // ids
-        glEnableVertexAttribArray(5);
-        glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-        // weights
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-        glBindVertexArray(0);
+        SetupVertexAttributes(format);
+        GLState::BindVertexArray(0);
+    }
+
+    // bounding sphere around the box center, used to project LOD errors
+    void computeBounds(span<const Vertex> vertices)
+    {
+        if (vertices.empty())
+            return;
+        glm::vec3 lo = vertices[0].pos, hi = vertices[0].pos;
+        for (const Vertex& vertex : vertices)
+        {
+            lo = glm::min(lo, vertex.pos);
+            hi = glm::max(hi, vertex.pos);
+        }
+        bounds_center = (lo + hi) * 0.5f;
+        bounds_radius = 0.0f;
+        for (const Vertex& vertex : vertices)
+            bounds_radius = std::max(bounds_radius, glm::length(vertex.pos - bounds_center));
     }
 };
-#endif
\ No newline at end of file
+#endif
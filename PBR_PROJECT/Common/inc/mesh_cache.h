@@ -0,0 +1,326 @@
+#ifndef __MESH_CACHE_H
+#define __MESH_CACHE_H
+
+#include "mesh.h"
+#include "bone.h"
+#include "hash_utils.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <format>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef MESH_CACHE_DIR
+#define MESH_CACHE_DIR "mesh_cache"
+#endif
+
+// Binary cache of the post-processed Assimp output.
+// The file is laid out so it can be mapped and consumed in place:
+//   header | mesh records | texture records | bone records | strings | vertex & index blobs
+// Bump kMeshCacheVersion whenever the layout or the processing in Model changes.
+constexpr uint32_t kMeshCacheMagic   = 0x48534D4C;	// "LMSH"
+constexpr uint32_t kMeshCacheVersion = 3;
+
+struct MeshCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t name_hash;
+	uint64_t source_hash;
+	uint32_t flags;
+	uint32_t vertex_size;
+	uint32_t mesh_count;
+	uint32_t texture_count;
+	uint32_t bone_count;
+	int32_t  bone_counter;
+	uint32_t options;
+	uint64_t strings_offset;
+	uint64_t strings_size;
+};
+
+struct MeshCacheLodRecord {
+	uint32_t first_index;
+	uint32_t index_count;
+	float	 error;
+};
+
+struct MeshCacheMeshRecord {
+	uint64_t		   vertex_offset;
+	uint64_t		   index_offset;
+	uint32_t		   vertex_count;
+	uint32_t		   index_count;
+	uint32_t		   texture_first;
+	uint32_t		   texture_count;
+	uint32_t		   lod_count;
+	uint32_t		   padding;
+	MeshCacheLodRecord lods[kMaxMeshLods];
+};
+
+struct MeshCacheTextureRecord {
+	uint32_t type_offset;
+	uint32_t type_size;
+	uint32_t path_offset;
+	uint32_t path_size;
+};
+
+struct MeshCacheBoneRecord {
+	float	 offset[16];
+	uint32_t name_offset;
+	uint32_t name_size;
+	int32_t  id;
+	uint32_t padding;
+};
+
+struct MeshCacheKey {
+	std::string source_path;
+	uint64_t	name_hash	= 0;	// path, flags and options, names the file so every variant keeps its own
+	uint64_t	source_hash = 0;
+	uint32_t	flags		= 0;
+	uint32_t	options		= 0;	// Model side processing on top of the import flags
+};
+
+class MeshCache {
+public:
+	// hash the source path and content together with the flags that shaped the processed data
+	static MeshCacheKey MakeKey(const std::string& source_path, uint32_t flags, uint32_t options = 0) {
+		MeshCacheKey key;
+		key.source_path = source_path;
+		key.flags		= flags;
+		key.options		= options;
+		key.name_hash	= HashValue(options, HashValue(flags, HashString(source_path)));
+		MappedFile source(source_path);
+		if (source.IsOpen()) {
+			key.source_hash = HashBytes(source.Data(), source.Size());
+		}
+		return key;
+	}
+
+	static std::filesystem::path CachePath(const MeshCacheKey& key) {
+		return std::filesystem::path(MESH_CACHE_DIR) / std::format("{:016x}.meshcache", key.name_hash);
+	}
+
+	// map the cache file, rejecting it when any part of the key or the layout mismatches
+	bool Open(const MeshCacheKey& key) {
+		if (key.source_hash == 0 || !file_.Open(CachePath(key).string())) return false;
+		if (file_.Size() < sizeof(MeshCacheHeader)) return Reject();
+
+		header_ = reinterpret_cast<const MeshCacheHeader*>(file_.Data());
+		if (header_->magic		 != kMeshCacheMagic   ||
+			header_->version	 != kMeshCacheVersion ||
+			header_->vertex_size != sizeof(Vertex)	  ||
+			header_->name_hash	 != key.name_hash	  ||
+			header_->source_hash != key.source_hash	  ||
+			header_->flags		 != key.flags			  ||
+			header_->options	 != key.options) {
+			return Reject();
+		}
+
+		size_t table_end = sizeof(MeshCacheHeader)
+			+ header_->mesh_count	 * sizeof(MeshCacheMeshRecord)
+			+ header_->texture_count * sizeof(MeshCacheTextureRecord)
+			+ header_->bone_count	 * sizeof(MeshCacheBoneRecord);
+		if (table_end > file_.Size() || !InRange(header_->strings_offset, header_->strings_size)) return Reject();
+
+		meshes_	  = reinterpret_cast<const MeshCacheMeshRecord*>(file_.Data() + sizeof(MeshCacheHeader));
+		textures_ = reinterpret_cast<const MeshCacheTextureRecord*>(meshes_ + header_->mesh_count);
+		bones_	  = reinterpret_cast<const MeshCacheBoneRecord*>(textures_ + header_->texture_count);
+
+		for (uint32_t i = 0; i < header_->mesh_count; ++i) {
+			const MeshCacheMeshRecord& rec = meshes_[i];
+			if (!InRange(rec.vertex_offset, uint64_t(rec.vertex_count) * sizeof(Vertex)) ||
+				!InRange(rec.index_offset,  uint64_t(rec.index_count)  * sizeof(unsigned int)) ||
+				uint64_t(rec.texture_first) + rec.texture_count > header_->texture_count ||
+				rec.lod_count > kMaxMeshLods) {
+				return Reject();
+			}
+			for (uint32_t l = 0; l < rec.lod_count; ++l) {
+				if (uint64_t(rec.lods[l].first_index) + rec.lods[l].index_count > rec.index_count) return Reject();
+			}
+		}
+		return true;
+	}
+
+	inline uint32_t MeshCount() const { return header_ ? header_->mesh_count : 0; }
+
+	std::span<const Vertex> Vertices(uint32_t mesh) const {
+		const MeshCacheMeshRecord& rec = meshes_[mesh];
+		return { reinterpret_cast<const Vertex*>(file_.Data() + rec.vertex_offset), rec.vertex_count };
+	}
+
+	std::span<const unsigned int> Indices(uint32_t mesh) const {
+		const MeshCacheMeshRecord& rec = meshes_[mesh];
+		return { reinterpret_cast<const unsigned int*>(file_.Data() + rec.index_offset), rec.index_count };
+	}
+
+	// empty when the mesh was stored without a LOD chain
+	std::vector<MeshLod> Lods(uint32_t mesh) const {
+		const MeshCacheMeshRecord& rec = meshes_[mesh];
+		std::vector<MeshLod> lods;
+		lods.reserve(rec.lod_count);
+		for (uint32_t l = 0; l < rec.lod_count; ++l) {
+			lods.push_back({ rec.lods[l].first_index, rec.lods[l].index_count, rec.lods[l].error });
+		}
+		return lods;
+	}
+
+	// texture references only, the images themselves are still loaded through the model
+	template<class Func>
+		requires std::invocable<Func, std::string_view, std::string_view>
+	void ForEachTexture(uint32_t mesh, Func&& func) const {
+		const MeshCacheMeshRecord& rec = meshes_[mesh];
+		for (uint32_t i = 0; i < rec.texture_count; ++i) {
+			const MeshCacheTextureRecord& tex = textures_[rec.texture_first + i];
+			func(String(tex.type_offset, tex.type_size), String(tex.path_offset, tex.path_size));
+		}
+	}
+
+	void ReadBoneInfo(std::map<std::string, BoneInfo>& bone_info_map, int& bone_counter) const {
+		for (uint32_t i = 0; i < header_->bone_count; ++i) {
+			const MeshCacheBoneRecord& rec = bones_[i];
+			BoneInfo info;
+			info.id = rec.id;
+			std::memcpy(&info.offset[0][0], rec.offset, sizeof(rec.offset));
+			bone_info_map[std::string(String(rec.name_offset, rec.name_size))] = info;
+		}
+		bone_counter = header_->bone_counter;
+	}
+
+	static bool Write(const MeshCacheKey& key, std::span<const MeshData> meshes,
+		const std::map<std::string, BoneInfo>& bone_info_map, int bone_counter) {
+		if (key.source_hash == 0) return false;
+
+		std::vector<MeshCacheMeshRecord>	mesh_recs;
+		std::vector<MeshCacheTextureRecord> tex_recs;
+		std::vector<MeshCacheBoneRecord>	bone_recs;
+		std::string							strings;
+		mesh_recs.reserve(meshes.size());
+		bone_recs.reserve(bone_info_map.size());
+
+		auto push_string = [&strings](std::string_view str) {
+			uint32_t offset = static_cast<uint32_t>(strings.size());
+			strings.append(str);
+			return offset;
+		};
+
+		for (const MeshData& mesh : meshes) {
+			MeshCacheMeshRecord rec{};
+			rec.vertex_count  = static_cast<uint32_t>(mesh.vertices.size());
+			rec.index_count	  = static_cast<uint32_t>(mesh.indices.size());
+			rec.texture_first = static_cast<uint32_t>(tex_recs.size());
+			rec.texture_count = static_cast<uint32_t>(mesh.textures.size());
+			rec.lod_count	  = static_cast<uint32_t>(std::min(mesh.lods.size(), kMaxMeshLods));
+			for (uint32_t l = 0; l < rec.lod_count; ++l) {
+				rec.lods[l] = { mesh.lods[l].first_index, mesh.lods[l].index_count, mesh.lods[l].error };
+			}
+			for (const Texture& tex : mesh.textures) {
+				MeshCacheTextureRecord tex_rec{};
+				tex_rec.type_offset = push_string(tex.type);
+				tex_rec.type_size	= static_cast<uint32_t>(tex.type.size());
+				tex_rec.path_offset = push_string(tex.path);
+				tex_rec.path_size	= static_cast<uint32_t>(tex.path.size());
+				tex_recs.push_back(tex_rec);
+			}
+			mesh_recs.push_back(rec);
+		}
+
+		for (const auto& [name, info] : bone_info_map) {
+			MeshCacheBoneRecord rec{};
+			std::memcpy(rec.offset, &info.offset[0][0], sizeof(rec.offset));
+			rec.name_offset = push_string(name);
+			rec.name_size	= static_cast<uint32_t>(name.size());
+			rec.id			= info.id;
+			bone_recs.push_back(rec);
+		}
+
+		MeshCacheHeader header{};
+		header.magic		  = kMeshCacheMagic;
+		header.version		  = kMeshCacheVersion;
+		header.name_hash	  = key.name_hash;
+		header.source_hash	  = key.source_hash;
+		header.flags		  = key.flags;
+		header.vertex_size	  = sizeof(Vertex);
+		header.mesh_count	  = static_cast<uint32_t>(mesh_recs.size());
+		header.texture_count  = static_cast<uint32_t>(tex_recs.size());
+		header.bone_count	  = static_cast<uint32_t>(bone_recs.size());
+		header.bone_counter	  = bone_counter;
+		header.options		  = key.options;
+		header.strings_offset = sizeof(MeshCacheHeader)
+			+ mesh_recs.size() * sizeof(MeshCacheMeshRecord)
+			+ tex_recs.size()  * sizeof(MeshCacheTextureRecord)
+			+ bone_recs.size() * sizeof(MeshCacheBoneRecord);
+		header.strings_size	  = strings.size();
+
+		// geometry blobs start 16 bytes aligned so the mapped spans are safe to hand to GL
+		uint64_t cursor = AlignUp(header.strings_offset + header.strings_size);
+		for (size_t i = 0; i < meshes.size(); ++i) {
+			mesh_recs[i].vertex_offset = cursor;
+			cursor = AlignUp(cursor + meshes[i].vertices.size() * sizeof(Vertex));
+			mesh_recs[i].index_offset  = cursor;
+			cursor = AlignUp(cursor + meshes[i].indices.size() * sizeof(unsigned int));
+		}
+
+		std::error_code ec;
+		std::filesystem::path path = CachePath(key);
+		std::filesystem::create_directories(path.parent_path(), ec);
+		std::filesystem::path tmp_path = path;
+		tmp_path += ".tmp";
+		{
+			std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+			if (!out.is_open()) return false;
+
+			auto write_at = [&out](uint64_t offset, const void* data, size_t size) {
+				out.seekp(static_cast<std::streamoff>(offset));
+				out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+			};
+			write_at(0, &header, sizeof(header));
+			out.write(reinterpret_cast<const char*>(mesh_recs.data()), mesh_recs.size() * sizeof(MeshCacheMeshRecord));
+			out.write(reinterpret_cast<const char*>(tex_recs.data()),  tex_recs.size()  * sizeof(MeshCacheTextureRecord));
+			out.write(reinterpret_cast<const char*>(bone_recs.data()), bone_recs.size() * sizeof(MeshCacheBoneRecord));
+			out.write(strings.data(), strings.size());
+			for (size_t i = 0; i < meshes.size(); ++i) {
+				write_at(mesh_recs[i].vertex_offset, meshes[i].vertices.data(), meshes[i].vertices.size() * sizeof(Vertex));
+				write_at(mesh_recs[i].index_offset,  meshes[i].indices.data(),  meshes[i].indices.size() * sizeof(unsigned int));
+			}
+			// pad the tail so the last blob is fully backed by the file
+			if (cursor > 0) write_at(cursor - 1, "", 1);
+			if (!out.good()) return false;
+		}
+		std::filesystem::rename(tmp_path, path, ec);
+		return !ec;
+	}
+
+private:
+	static inline uint64_t AlignUp(uint64_t val) { return (val + 15) & ~uint64_t(15); }
+
+	inline bool InRange(uint64_t offset, uint64_t size) const {
+		return offset <= file_.Size() && size <= file_.Size() - offset;
+	}
+
+	inline std::string_view String(uint32_t offset, uint32_t size) const {
+		const char* base = reinterpret_cast<const char*>(file_.Data() + header_->strings_offset);
+		return offset + uint64_t(size) <= header_->strings_size ? std::string_view(base + offset, size) : std::string_view();
+	}
+
+	inline bool Reject() {
+		file_.Close();
+		header_ = nullptr;
+		return false;
+	}
+
+private:
+	MappedFile					  file_;
+	const MeshCacheHeader*		  header_	= nullptr;
+	const MeshCacheMeshRecord*	  meshes_	= nullptr;
+	const MeshCacheTextureRecord* textures_ = nullptr;
+	const MeshCacheBoneRecord*	  bones_	= nullptr;
+};
+
+#endif // !__MESH_CACHE_H
@@ -0,0 +1,269 @@
+#ifndef __MESH_OPTIMIZER_H
+#define __MESH_OPTIMIZER_H
+
+#include "vertex_format.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Import time reordering of indexed triangle lists:
+//   OptimizeVertexCache  - triangle order for post-transform cache hits (Forsyth's linear-speed algorithm)
+//   OptimizeOverdraw	  - cluster order so outward facing parts are drawn first (Sander et al. 2007)
+//   OptimizeVertexFetch  - vertex order matching first use, so fetches walk memory forwards
+// Run them in that order, each later pass keeps the wins of the earlier ones.
+
+struct VertexCacheStats {
+	float acmr = 0.0f;	// average cache miss ratio, transformed vertices per triangle (0.5 .. 3)
+	float atvr = 0.0f;	// average transform to vertex ratio, 1 is optimal
+};
+
+// simulates a FIFO post-transform cache of cache_size entries, roughly what current hardware behaves like
+inline VertexCacheStats AnalyzeVertexCache(std::span<const unsigned int> indices, size_t vertex_count, unsigned int cache_size = 16)
+{
+	VertexCacheStats stats;
+	if (indices.empty() || vertex_count == 0) return stats;
+
+	// a vertex is cached while its insertion stamp is within cache_size of the current one
+	std::vector<size_t> stamps(vertex_count, 0);
+	std::vector<bool>	used(vertex_count, false);
+	size_t stamp = cache_size + 1, misses = 0, unique = 0;
+	for (unsigned int index : indices) {
+		if (!used[index]) {
+			used[index] = true;
+			++unique;
+		}
+		if (stamp - stamps[index] > cache_size) {
+			stamps[index] = stamp++;
+			++misses;
+		}
+	}
+	stats.acmr = static_cast<float>(misses) / (indices.size() / 3);
+	stats.atvr = static_cast<float>(misses) / unique;
+	return stats;
+}
+
+namespace forsyth {
+	constexpr int	kCacheSize		   = 32;
+	constexpr float kCacheDecayPower   = 1.5f;
+	constexpr float kLastTriScore	   = 0.75f;
+	constexpr float kValenceBoostScale = 2.0f;
+	constexpr float kValenceBoostPower = 0.5f;
+
+	inline float VertexScore(int cache_pos, unsigned int remaining)
+	{
+		// no triangle left to draw with this vertex, it should not pull anything
+		if (remaining == 0) return -1.0f;
+		float score = 0.0f;
+		if (cache_pos >= 0) {
+			// the three vertices of the last triangle score the same, regardless of order
+			score = cache_pos < 3 ? kLastTriScore
+				: std::pow(1.0f - static_cast<float>(cache_pos - 3) / (kCacheSize - 3), kCacheDecayPower);
+		}
+		// boost vertices with few triangles left, finishing them off avoids lone stragglers later
+		return score + kValenceBoostScale * std::pow(static_cast<float>(remaining), -kValenceBoostPower);
+	}
+}
+
+inline void OptimizeVertexCache(std::span<unsigned int> indices, size_t vertex_count)
+{
+	using namespace forsyth;
+	const size_t tri_count = indices.size() / 3;
+	if (tri_count < 2) return;
+
+	// vertex -> triangles adjacency, remaining[v] live entries from offsets[v]
+	std::vector<unsigned int> remaining(vertex_count, 0);
+	for (unsigned int index : indices) ++remaining[index];
+	std::vector<unsigned int> offsets(vertex_count + 1, 0);
+	std::partial_sum(remaining.begin(), remaining.end(), offsets.begin() + 1);
+	std::vector<unsigned int> adjacency(indices.size());
+	{
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i) adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+	}
+
+	std::vector<int>   cache_pos(vertex_count, -1);
+	std::vector<float> vertex_score(vertex_count);
+	for (size_t v = 0; v < vertex_count; ++v) vertex_score[v] = VertexScore(-1, remaining[v]);
+	std::vector<float> tri_score(tri_count, 0.0f);
+	for (size_t i = 0; i < indices.size(); ++i) tri_score[i / 3] += vertex_score[indices[i]];
+	std::vector<bool> emitted(tri_count, false);
+
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+	std::vector<unsigned int> cache, next_cache;
+	cache.reserve(kCacheSize + 3);
+	next_cache.reserve(kCacheSize + 3);
+
+	size_t best = std::max_element(tri_score.begin(), tri_score.end()) - tri_score.begin();
+	size_t cursor = 0;
+	while (best < tri_count) {
+		emitted[best] = true;
+		const unsigned int* tri = &indices[best * 3];
+		output.insert(output.end(), tri, tri + 3);
+
+		// drop the triangle from the adjacency of its vertices
+		for (int k = 0; k < 3; ++k) {
+			unsigned int v = tri[k];
+			unsigned int* begin = &adjacency[offsets[v]];
+			unsigned int* end	= begin + remaining[v];
+			unsigned int* iter	= std::find(begin, end, static_cast<unsigned int>(best));
+			if (iter != end) {
+				std::swap(*iter, *(end - 1));
+				--remaining[v];
+			}
+		}
+
+		// LRU: the triangle moves to the front, everything else shifts back
+		next_cache.clear();
+		for (int k = 0; k < 3; ++k)
+			if (std::find(next_cache.begin(), next_cache.end(), tri[k]) == next_cache.end()) next_cache.push_back(tri[k]);
+		for (unsigned int v : cache)
+			if (std::find(next_cache.begin(), next_cache.end(), v) == next_cache.end()) next_cache.push_back(v);
+
+		// rescore every vertex that moved or fell out and push the difference to its triangles
+		for (size_t i = 0; i < next_cache.size(); ++i) {
+			unsigned int v = next_cache[i];
+			cache_pos[v] = i < static_cast<size_t>(kCacheSize) ? static_cast<int>(i) : -1;
+			float score = VertexScore(cache_pos[v], remaining[v]);
+			float delta = score - vertex_score[v];
+			vertex_score[v] = score;
+			for (unsigned int j = 0; j < remaining[v]; ++j) tri_score[adjacency[offsets[v] + j]] += delta;
+		}
+		if (next_cache.size() > static_cast<size_t>(kCacheSize)) next_cache.resize(kCacheSize);
+		cache.swap(next_cache);
+
+		// the next triangle is the best one touching the cache
+		best = tri_count;
+		float best_score = -1.0f;
+		for (unsigned int v : cache) {
+			for (unsigned int j = 0; j < remaining[v]; ++j) {
+				unsigned int t = adjacency[offsets[v] + j];
+				if (tri_score[t] > best_score) {
+					best_score = tri_score[t];
+					best	   = t;
+				}
+			}
+		}
+		// dead end, restart from the first triangle not drawn yet
+		if (best == tri_count) {
+			while (cursor < tri_count && emitted[cursor]) ++cursor;
+			best = cursor;
+		}
+	}
+	std::copy(output.begin(), output.end(), indices.begin());
+}
+
+// Splits the (cache optimized) triangle list into clusters where the cache starts cold anyway
+// or the running miss ratio stays within threshold, then sorts the clusters front to back
+// by how much they face away from the mesh center. Reverts if the ACMR grows past threshold.
+inline void OptimizeOverdraw(std::span<unsigned int> indices, std::span<const Vertex> vertices, float threshold = 1.05f)
+{
+	const size_t tri_count = indices.size() / 3;
+	if (tri_count < 2) return;
+	const unsigned int cache_size = 16;
+	VertexCacheStats before = AnalyzeVertexCache(indices, vertices.size(), cache_size);
+
+	// cluster boundaries from a FIFO replay of the current order
+	std::vector<size_t> clusters{ 0 };
+	{
+		std::vector<size_t> stamps(vertices.size(), 0);
+		size_t stamp = cache_size + 1, cluster_misses = 0;
+		for (size_t t = 0; t < tri_count; ++t) {
+			int misses = 0;
+			for (int k = 0; k < 3; ++k) {
+				unsigned int v = indices[t * 3 + k];
+				if (stamp - stamps[v] > cache_size) {
+					stamps[v] = stamp++;
+					++misses;
+				}
+			}
+			size_t cluster_tris = t - clusters.back();
+			bool hard = misses == 3;
+			bool soft = cluster_tris > 0 && static_cast<float>(cluster_misses) / cluster_tris <= before.acmr * threshold;
+			if (cluster_tris > 0 && (hard || (soft && cluster_tris >= cache_size))) {
+				clusters.push_back(t);
+				cluster_misses = 0;
+			}
+			cluster_misses += misses;
+		}
+	}
+	if (clusters.size() < 2) return;
+	clusters.push_back(tri_count);
+
+	// area weighted centroid and normal of the whole mesh and of each cluster
+	glm::vec3 mesh_center(0.0f);
+	float mesh_area = 0.0f;
+	std::vector<float> sort_keys(clusters.size() - 1);
+	std::vector<glm::vec3> centers(sort_keys.size()), normals(sort_keys.size());
+	for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+		glm::vec3 center(0.0f), normal(0.0f);
+		float area = 0.0f;
+		for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+			const glm::vec3& p0 = vertices[indices[t * 3 + 0]].pos;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].pos;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].pos;
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			float a = glm::length(n);
+			center += (p0 + p1 + p2) * (a / 3.0f);
+			normal += n;
+			area += a;
+		}
+		mesh_center += center;
+		mesh_area	+= area;
+		centers[c] = area > 0.0f ? center / area : vertices[indices[clusters[c] * 3]].pos;
+		float len  = glm::length(normal);
+		normals[c] = len > 0.0f ? normal / len : glm::vec3(0.0f);
+	}
+	if (mesh_area > 0.0f) mesh_center /= mesh_area;
+	for (size_t c = 0; c < sort_keys.size(); ++c) sort_keys[c] = glm::dot(centers[c] - mesh_center, normals[c]);
+
+	std::vector<size_t> order(sort_keys.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sort_keys[a] > sort_keys[b]; });
+
+	std::vector<unsigned int> output;
+	output.reserve(indices.size());
+	for (size_t c : order)
+		output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+
+	VertexCacheStats after = AnalyzeVertexCache(output, vertices.size(), cache_size);
+	if (after.acmr <= before.acmr * threshold) std::copy(output.begin(), output.end(), indices.begin());
+}
+
+// renumbers vertices in order of first reference, unreferenced vertices move to the end
+inline void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::span<unsigned int> indices)
+{
+	constexpr unsigned int kUnmapped = ~0u;
+	std::vector<unsigned int> remap(vertices.size(), kUnmapped);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+	for (unsigned int& index : indices) {
+		if (remap[index] == kUnmapped) {
+			remap[index] = static_cast<unsigned int>(reordered.size());
+			reordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	for (size_t v = 0; v < vertices.size(); ++v)
+		if (remap[v] == kUnmapped) reordered.push_back(vertices[v]);
+	vertices.swap(reordered);
+}
+
+// all three passes, returns the cache statistics before and after
+inline std::pair<VertexCacheStats, VertexCacheStats> OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	VertexCacheStats before = AnalyzeVertexCache(indices, vertices.size());
+	OptimizeVertexCache(indices, vertices.size());
+	OptimizeOverdraw(indices, vertices);
+	OptimizeVertexFetch(vertices, indices);
+	return { before, AnalyzeVertexCache(indices, vertices.size()) };
+}
+
+#endif // !__MESH_OPTIMIZER_H
@@ -0,0 +1,236 @@
+#ifndef __MESH_SIMPLIFIER_H
+#define __MESH_SIMPLIFIER_H
+
+#include "hash_utils.h"
+#include "vertex_format.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Quadric error metric simplification (Garland & Heckbert 1997) restricted to half edge collapses:
+// a vertex is always merged into one of its neighbours, so the result indexes the input vertex buffer
+// and LODs can share it with the base mesh. Open borders and attribute seams (several vertices at
+// one position) are kept in place, which preserves silhouettes and UV layout.
+
+struct Quadric {
+	// symmetric 3x3 part, linear part and constant of p^T A p + 2 b.p + c, and the summed plane weights
+	double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+	double b0  = 0, b1  = 0, b2  = 0, c = 0;
+	double w   = 0;
+
+	static Quadric FromPlane(const glm::dvec3& n, double d, double weight) {
+		Quadric q;
+		q.a00 = n.x * n.x * weight; q.a01 = n.x * n.y * weight; q.a02 = n.x * n.z * weight;
+		q.a11 = n.y * n.y * weight; q.a12 = n.y * n.z * weight; q.a22 = n.z * n.z * weight;
+		q.b0  = n.x * d * weight;	q.b1  = n.y * d * weight;	q.b2  = n.z * d * weight;
+		q.c	  = d * d * weight;
+		q.w	  = weight;
+		return q;
+	}
+
+	Quadric& operator+=(const Quadric& o) {
+		a00 += o.a00; a01 += o.a01; a02 += o.a02; a11 += o.a11; a12 += o.a12; a22 += o.a22;
+		b0	+= o.b0;  b1  += o.b1;	b2	+= o.b2;  c	  += o.c;
+		w	+= o.w;
+		return *this;
+	}
+
+	// weighted mean of the squared distances from p to the planes, in squared length units
+	double Eval(const glm::vec3& p) const {
+		if (w <= 0.0) return 0.0;
+		double x = p.x, y = p.y, z = p.z;
+		double err = a00 * x * x + a11 * y * y + a22 * z * z
+			+ 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+			+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+		return std::max(err / w, 0.0);
+	}
+};
+
+// radius of the bounding box, the unit the relative errors below are measured in
+inline float MeshExtent(std::span<const Vertex> vertices)
+{
+	if (vertices.empty()) return 0.0f;
+	glm::vec3 lo = vertices[0].pos, hi = vertices[0].pos;
+	for (const Vertex& vertex : vertices) {
+		lo = glm::min(lo, vertex.pos);
+		hi = glm::max(hi, vertex.pos);
+	}
+	return glm::length(hi - lo) * 0.5f;
+}
+
+// Reduces indices towards target_index_count without exceeding target_error (relative to MeshExtent).
+// result_error receives the largest error actually introduced, in the same relative unit.
+inline std::vector<unsigned int> SimplifyMesh(std::span<const unsigned int> indices, std::span<const Vertex> vertices,
+	size_t target_index_count, float target_error, float* result_error = nullptr)
+{
+	std::vector<unsigned int> tris(indices.begin(), indices.end());
+	if (result_error) *result_error = 0.0f;
+	float extent = MeshExtent(vertices);
+	if (tris.size() <= target_index_count || extent <= 0.0f) return tris;
+
+	const size_t vertex_count = vertices.size();
+	const double scale = 1.0 / extent;	// quadrics work in normalised units so the error limit is scale free
+	auto pos = [&](unsigned int v) { return vertices[v].pos; };
+
+	// weld vertices by position, wedges[v] is the first vertex sharing v's position
+	std::vector<unsigned int> wedge(vertex_count);
+	std::vector<unsigned int> wedge_count(vertex_count, 0);
+	{
+		struct PosHash {
+			size_t operator()(const glm::vec3& p) const { return static_cast<size_t>(HashValue(p)); }
+		};
+		std::unordered_map<glm::vec3, unsigned int, PosHash> first;
+		first.reserve(vertex_count);
+		for (unsigned int v = 0; v < vertex_count; ++v) {
+			auto [iter, _] = first.emplace(pos(v), v);
+			wedge[v] = iter->second;
+			++wedge_count[iter->second];
+		}
+	}
+
+	// locked: on a seam or on an open border edge
+	std::vector<bool> locked(vertex_count, false);
+	for (unsigned int v = 0; v < vertex_count; ++v) locked[v] = wedge_count[wedge[v]] > 1;
+	{
+		std::unordered_map<uint64_t, int> edge_uses;
+		edge_uses.reserve(tris.size());
+		auto edge_key = [&](unsigned int a, unsigned int b) {
+			a = wedge[a]; b = wedge[b];
+			return a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+		};
+		for (size_t t = 0; t < tris.size(); t += 3)
+			for (int k = 0; k < 3; ++k) ++edge_uses[edge_key(tris[t + k], tris[t + (k + 1) % 3])];
+		for (size_t t = 0; t < tris.size(); t += 3) {
+			for (int k = 0; k < 3; ++k) {
+				unsigned int a = tris[t + k], b = tris[t + (k + 1) % 3];
+				if (edge_uses[edge_key(a, b)] != 2) {
+					locked[wedge[a]] = true;
+					locked[wedge[b]] = true;
+				}
+			}
+		}
+		for (unsigned int v = 0; v < vertex_count; ++v) locked[v] = locked[wedge[v]];
+	}
+
+	// area weighted plane quadrics, accumulated per welded position. Eval divides by the summed area so
+	// a cost is a squared distance whatever the triangle sizes, comparable with target_error^2
+	std::vector<Quadric> quadrics(vertex_count);
+	for (size_t t = 0; t < tris.size(); t += 3) {
+		glm::dvec3 p0 = glm::dvec3(pos(tris[t + 0])) * scale;
+		glm::dvec3 p1 = glm::dvec3(pos(tris[t + 1])) * scale;
+		glm::dvec3 p2 = glm::dvec3(pos(tris[t + 2])) * scale;
+		glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+		double area = glm::length(n);
+		if (area <= 0.0) continue;
+		n /= area;
+		Quadric q = Quadric::FromPlane(n, -glm::dot(n, p0), area);
+		for (int k = 0; k < 3; ++k) quadrics[wedge[tris[t + k]]] += q;
+	}
+
+	struct Collapse {
+		unsigned int from;
+		unsigned int to;
+		double		 cost;
+	};
+
+	const double max_cost = double(target_error) * target_error;
+	double worst_cost = 0.0;
+	std::vector<unsigned int> adjacency, offsets(vertex_count + 1), remap(vertex_count);
+	std::vector<bool> touched(vertex_count);
+	std::vector<Collapse> collapses;
+
+	while (tris.size() > target_index_count) {
+		// vertex -> triangle adjacency of the current list
+		std::fill(offsets.begin(), offsets.end(), 0);
+		for (unsigned int v : tris) ++offsets[v + 1];
+		for (size_t v = 0; v < vertex_count; ++v) offsets[v + 1] += offsets[v];
+		adjacency.resize(tris.size());
+		{
+			std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < tris.size(); ++i) adjacency[fill[tris[i]]++] = static_cast<unsigned int>(i / 3);
+		}
+
+		collapses.clear();
+		for (size_t t = 0; t < tris.size(); t += 3) {
+			for (int k = 0; k < 3; ++k) {
+				unsigned int a = tris[t + k], b = tris[t + (k + 1) % 3];
+				for (auto [from, to] : { std::pair{ a, b }, std::pair{ b, a } }) {
+					if (locked[from]) continue;
+					Quadric q = quadrics[from];
+					q += quadrics[wedge[to]];
+					double cost = q.Eval(glm::vec3(glm::dvec3(pos(to)) * scale));
+					if (cost <= max_cost) collapses.push_back({ from, to, cost });
+				}
+			}
+		}
+		if (collapses.empty()) break;
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r) { return l.cost < r.cost; });
+
+		// apply the cheapest independent collapses, an interior collapse removes about two triangles
+		std::fill(touched.begin(), touched.end(), false);
+		for (unsigned int v = 0; v < vertex_count; ++v) remap[v] = v;
+		size_t removable = (tris.size() - target_index_count) / 3;
+		size_t removed = 0, applied = 0;
+		for (const Collapse& collapse : collapses) {
+			if (removed >= removable) break;
+			if (touched[collapse.from] || touched[wedge[collapse.to]]) continue;
+
+			// reject collapses that flip or degenerate a surviving triangle
+			bool valid = true;
+			int dying = 0;
+			glm::vec3 target = pos(collapse.to);
+			for (unsigned int j = offsets[collapse.from]; j < offsets[collapse.from + 1] && valid; ++j) {
+				const unsigned int* tri = &tris[adjacency[j] * 3];
+				bool shared = false;
+				for (int k = 0; k < 3; ++k) shared |= wedge[tri[k]] == wedge[collapse.to];
+				if (shared) {
+					++dying;
+					continue;
+				}
+				glm::vec3 p[3], q[3];
+				for (int k = 0; k < 3; ++k) {
+					p[k] = pos(tri[k]);
+					q[k] = tri[k] == collapse.from ? target : p[k];
+				}
+				glm::vec3 n_old = glm::cross(p[1] - p[0], p[2] - p[0]);
+				glm::vec3 n_new = glm::cross(q[1] - q[0], q[2] - q[0]);
+				valid = glm::dot(n_old, n_new) > 0.0f;
+			}
+			if (!valid || dying == 0) continue;
+
+			// lock the one ring for the rest of the pass so adjacency stays valid
+			for (unsigned int j = offsets[collapse.from]; j < offsets[collapse.from + 1]; ++j)
+				for (int k = 0; k < 3; ++k) touched[wedge[tris[adjacency[j] * 3 + k]]] = true;
+			touched[collapse.from] = true;
+			remap[collapse.from] = collapse.to;
+			quadrics[wedge[collapse.to]] += quadrics[collapse.from];
+			worst_cost = std::max(worst_cost, collapse.cost);
+			removed += dying;
+			++applied;
+		}
+		if (applied == 0) break;
+
+		// rewrite and drop triangles that collapsed to an edge
+		size_t write = 0;
+		for (size_t t = 0; t < tris.size(); t += 3) {
+			unsigned int a = remap[tris[t]], b = remap[tris[t + 1]], c = remap[tris[t + 2]];
+			if (wedge[a] == wedge[b] || wedge[b] == wedge[c] || wedge[a] == wedge[c]) continue;
+			tris[write++] = a;
+			tris[write++] = b;
+			tris[write++] = c;
+		}
+		tris.resize(write);
+	}
+
+	// worst_cost is a squared distance in normalised units, its root is in the unit of target_error
+	if (result_error) *result_error = static_cast<float>(std::sqrt(worst_cost));
+	return tris;
+}
+
+#endif // !__MESH_SIMPLIFIER_H
@@ -10,21 +10,60 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include "alloc_tracker.h"
 #include "assimputils.h"
 #include "mesh.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
 #include "shader.h"
 #include "bone.h"
-
+#include "logger.h"
+#include "texture_array.h"
+#include "texture_cache.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <format>
 #include <string>
 #include <fstream>
+#include <future>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 using namespace std;
 
 unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false);
 
+// post-process steps applied on import, also part of the mesh cache key
+constexpr unsigned int kModelImportFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+
+// Model side processing recorded in the mesh cache key
+constexpr uint32_t kModelOptionOptimize = 1u << 0;
+constexpr uint32_t kModelOptionLods     = 1u << 1;
+
+// deviation each LOD step may add, relative to the mesh extent
+constexpr float kLodStepMaxError = 0.05f;
+
+// per model import settings
+struct ModelLoadOptions {
+    bool         gamma  = false;
+    VertexFormat format = VertexFormat::eFull;    // GPU vertex layout of every mesh
+    bool         shared_arena = false;            // place meshes in GeometryArena::Shared and draw them batched
+    bool         optimize = false;                // reorder for vertex cache, overdraw and fetch locality on import
+    bool         lods = false;                    // build a simplified LOD chain per mesh, selected by Draw(shader, view)
+    bool         texture_arrays = false;          // with shared_arena: pack material textures into 2D arrays by size, so
+                                                  // batches are split by size class rather than by texture set. The shader
+                                                  // has to read them, see TEXTURE_ARRAYS in mesh_render.frag
+    MeshResidency residency = MeshResidency::eKeep; // CPU geometry kept after upload
+};
+
 class Model
 {
 public:
@@ -37,46 +76,447 @@ public:
 private:
     std::map<string, BoneInfo> m_boneinfo_map;
     int m_bone_counter = 0;
+    // path -> index into textures_loaded
+    std::unordered_map<string, size_t> m_texture_lookup;
+    ModelLoadOptions m_options;
+
+    // meshes sharing an arena and a texture set, drawn by one multi draw
+    struct DrawBatch {
+        GeometryArena*                      arena;
+        Material                            material;
+        vector<DrawElementsIndirectCommand> commands;
+        vector<size_t>                      mesh_ids;   // meshes[mesh_ids[i]] is drawn by commands[i]
+        vector<glm::ivec4>                  layers;     // packed batches: array layers of commands[i], fetched through base instance
+        unsigned int                        indirect_buffer = 0;
+        unsigned int                        layer_buffer = 0;
+    };
+    vector<DrawBatch> m_batches;
+    TextureArrays     m_texture_arrays;
+    bool              m_pack_pending = false;   // texture_arrays asked for while an async load still decodes textures
+
+    // state of a LoadAsync import, shared with the worker running it. Only the GL thread touches the
+    // pointer, Poll resets it once the import is done
+    struct AsyncLoad {
+        std::mutex                       mut;
+        std::deque<MeshData>             ready;     // imported, waiting for Poll to upload them
+        chrono::steady_clock::time_point start;
+        string                           path;
+        bool                             warm = false;
+        AllocScope                       allocs;
+    };
+    std::unique_ptr<AsyncLoad> m_async;
+    // the import task of LoadAsync, set before LoadAsync returns and never reset, so any thread may wait on it
+    std::shared_future<void>   m_imported;
 
 public:
     // constructor, expects a filepath to a 3D model.
-    Model(string const& path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const& path, bool gamma = false) : Model(path, ModelLoadOptions{ .gamma = gamma })
+    {
+    }
+
+    Model(string const& path, const ModelLoadOptions& options) : gammaCorrection(options.gamma), m_options(options)
     {
         loadModel(path);
     }
 
+    // starts loading on ThreadPool::Global() and returns at once. Poll(), which Draw calls, uploads meshes
+    // as the import hands them over; textures show a placeholder until decoded.
+    // The bone info is only complete once IsImported() is true, and never changes after that.
+    static std::unique_ptr<Model> LoadAsync(string const& path, const ModelLoadOptions& options = {})
+    {
+        std::unique_ptr<Model> model(new Model(options));
+        Model* self = model.get();
+        self->directory = path.substr(0, path.find_last_of('/'));
+        self->m_async = std::make_unique<AsyncLoad>();
+        self->m_async->start = chrono::steady_clock::now();
+        self->m_async->path = path;
+        self->m_imported = ThreadPool::Global().Submit([self, path] {
+            AsyncLoad& async = *self->m_async;
+            async.warm = self->importMeshes(path, [&async](MeshData&& data) {
+                std::lock_guard<std::mutex> lock(async.mut);
+                async.ready.push_back(std::move(data));
+            });
+        });
+        return model;
+    }
+
+    // textures are shared through the TextureCache, hand back our references
+    ~Model()
+    {
+        // the import task writes into this model
+        WaitImported();
+        for (const Texture& texture : textures_loaded)
+            TextureCache::Release(texture.id);
+        releaseBatches();
+        m_texture_arrays.Release();
+    }
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
     // draws the model, and thus all its meshes
     void Draw(Shader& shader)
     {
-        for (unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+        Poll();
+        drawMeshes(shader, nullptr);
+    }
+
+    // draws every mesh at the LOD its projected size asks for
+    void Draw(Shader& shader, const LodView& view)
+    {
+        Poll();
+        drawMeshes(shader, &view);
+    }
+
+    // GL thread: uploads the meshes an async import has finished and the textures whose decode completed
+    void Poll()
+    {
+        TextureCache::Poll();
+        // the batches are rebuilt over texture arrays once the last texture is decoded
+        if (m_pack_pending && texturesDecoded())
+            buildBatches();
+        if (!m_async)
+            return;
+        // checked before draining, everything is queued by the time the import reports ready
+        bool imported = IsImported();
+        std::deque<MeshData> ready;
+        {
+            std::lock_guard<std::mutex> lock(m_async->mut);
+            ready.swap(m_async->ready);
+        }
+        for (MeshData& data : ready)
+            createMesh(std::move(data));
+        TextureCache::FlushAsync();
+        if (!imported)
+            return;
+
+        m_imported.get();
+        finishLoad(m_async->path, m_async->start, m_async->warm);
+        m_async->allocs.Report(std::format("async load of {}", m_async->path));
+        m_async.reset();
     }
 
-    inline auto& GetBoneInfoMap() { return m_boneinfo_map; }
-    inline int & GetBoneCount()   { return m_bone_counter;}
+    // every mesh is drawable, textures may still be decoding
+    inline bool IsLoaded() const { return !m_async; }
+
+    // the import itself is done, bone info can be read. Safe from any thread, as is WaitImported
+    inline bool IsImported() const
+    {
+        return !m_imported.valid() || m_imported.wait_for(chrono::seconds(0)) == future_status::ready;
+    }
+
+    // a pool worker runs other queued tasks while the import finishes. Any other thread, the GL thread
+    // in ~Model included, blocks without touching ThreadPool::Global(), which may already be destroyed
+    // when a model lives at namespace scope
+    inline void WaitImported() const
+    {
+        if (IsImported())
+            return;
+        if (ThreadPool* pool = ThreadPool::Current())
+            pool->Wait(m_imported);
+        else
+            m_imported.wait();
+    }
+
+    // key of the mesh cache entry a load of path with options reads and refreshes
+    static MeshCacheKey CacheKey(string const& path, const ModelLoadOptions& options)
+    {
+        return MeshCache::MakeKey(path, kModelImportFlags,
+            (options.optimize ? kModelOptionOptimize : 0) | (options.lods ? kModelOptionLods : 0));
+    }
+
+    // CPU vs GPU bytes of the geometry, textures are counted separately as they are shared between models
+    void MemoryReport(string_view name) const
+    {
+        size_t cpu = 0, gpu = 0, textures = 0;
+        for (const Mesh& mesh : meshes)
+        {
+            cpu += mesh.CpuBytes();
+            gpu += mesh.GpuBytes();
+        }
+        for (const Texture& texture : textures_loaded)
+            textures += TextureCache::Bytes(texture.id);
+        constexpr double kMB = 1024.0 * 1024.0;
+        Logger::Message(std::format("model {} - {} meshes, geometry CPU {:.2f} MB / GPU {:.2f} MB, textures {:.2f} MB",
+            name, meshes.size(), cpu / kMB, gpu / kMB, textures / kMB));
+    }
+
+    // read only, filled by the import; an animation adds the bones it misses to a copy of its own
+    inline const std::map<string, BoneInfo>& GetBoneInfoMap() const { return m_boneinfo_map; }
+    inline int GetBoneCount() const { return m_bone_counter; }
 
 private:
+    void drawMeshes(Shader& shader, const LodView* view)
+    {
+        if (m_batches.empty())
+        {
+            glVertexAttribI4i(kMaterialLayerAttribute, -1, -1, -1, -1);
+            for (unsigned int i = 0; i < meshes.size(); i++)
+                meshes[i].Draw(shader, view ? meshes[i].SelectLod(*view) : 0);
+            return;
+        }
+
+        // arena meshes: one texture setup and one draw call per batch
+        for (DrawBatch& batch : m_batches)
+        {
+            bool packed = !batch.layers.empty();
+            // retarget the commands whose mesh changed LOD since the last frame
+            bool dirty = false;
+            for (size_t i = 0; i < batch.commands.size(); ++i)
+            {
+                const Mesh& mesh = meshes[batch.mesh_ids[i]];
+                const MeshLod& level = mesh.lods[view ? mesh.SelectLod(*view) : 0];
+                DrawElementsIndirectCommand& cmd = batch.commands[i];
+                if (cmd.count != level.index_count)
+                {
+                    cmd.count       = level.index_count;
+                    cmd.first_index = mesh.range.first_index + level.first_index;
+                    dirty = true;
+                }
+            }
+
+            batch.material.Bind(shader);
+            batch.arena->Bind();
+            // unpacked draws read layer -1 and sample the 2D textures
+            if (!packed)
+                glVertexAttribI4i(kMaterialLayerAttribute, -1, -1, -1, -1);
+            if (batch.indirect_buffer)
+            {
+                // one layer entry per command, the instanced attribute starts at the command's base instance
+                if (packed)
+                {
+                    glBindBuffer(GL_ARRAY_BUFFER, batch.layer_buffer);
+                    glEnableVertexAttribArray(kMaterialLayerAttribute);
+                    glVertexAttribIPointer(kMaterialLayerAttribute, 4, GL_INT, sizeof(glm::ivec4), nullptr);
+                    glVertexAttribDivisor(kMaterialLayerAttribute, 1);
+                }
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.indirect_buffer);
+                if (dirty)
+                    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, batch.commands.size() * sizeof(DrawElementsIndirectCommand), batch.commands.data());
+                glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(batch.commands.size()), 0);
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+                if (packed)
+                    glDisableVertexAttribArray(kMaterialLayerAttribute);
+            }
+            else
+            {
+                // still one texture setup for the batch, the layers go in as a constant attribute per draw
+                for (size_t i = 0; i < batch.commands.size(); ++i)
+                {
+                    const DrawElementsIndirectCommand& cmd = batch.commands[i];
+                    if (packed)
+                        glVertexAttribI4iv(kMaterialLayerAttribute, &batch.layers[i][0]);
+                    glDrawElementsBaseVertex(GL_TRIANGLES, cmd.count, GL_UNSIGNED_INT,
+                        (void*)(cmd.first_index * sizeof(unsigned int)), cmd.base_vertex);
+                }
+            }
+        }
+    }
+
+    explicit Model(const ModelLoadOptions& options) : gammaCorrection(options.gamma), m_options(options)
+    {
+    }
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const& path)
     {
+        AllocScope allocs;
+        auto start = chrono::steady_clock::now();
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+
+        bool warm = importMeshes(path, [this](MeshData&& data) { createMesh(std::move(data)); });
+        // decode every texture the meshes referenced in one parallel batch
+        TextureCache::Flush();
+        finishLoad(path, start, warm);
+        allocs.Report(std::format("load of {}", path));
+    }
+
+    void finishLoad(string const& path, chrono::steady_clock::time_point start, bool warm)
+    {
+        if (m_options.shared_arena)
+            buildBatches();
+
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        size_t vertex_bytes = 0;
+        for (const Mesh& mesh : meshes)
+            vertex_bytes += mesh.vertex_count * mesh.VertexStride();
+        Logger::Message(std::format("model loaded ({}) {} - {} meshes, {:.2f} MB vertex data in {:.2f} ms",
+            warm ? "warm" : "cold", path, meshes.size(), vertex_bytes / (1024.0 * 1024.0), ms));
+        MemoryReport(path);
+    }
+
+    // CPU side of loading, touches no GL state so it may run on a worker. Hands every mesh to sink once it
+    // is processed and fills the bone info. A warm start maps the binary mesh cache instead, a cold start
+    // imports through ASSIMP and refreshes the cache. Returns whether the cache was hit.
+    template<class Sink>
+    bool importMeshes(string const& path, Sink&& sink)
+    {
+        MeshCacheKey key = CacheKey(path, m_options);
+        if (loadFromCache(key, sink))
+            return true;
+
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(path, kModelImportFlags);
         // check for errors
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            return false;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        vector<MeshData> imported;
+        imported.reserve(scene->mNumMeshes);
+        processNode(scene->mRootNode, scene, [&imported](MeshData&& data) { imported.push_back(std::move(data)); });
+
+        // the cache is written from the imported data before it moves on, so nothing is copied for it
+        if (!MeshCache::Write(key, imported, m_boneinfo_map, m_bone_counter))
+            Logger::Warning(std::format("mesh cache write failed for {}", path));
+        for (MeshData& data : imported)
+            sink(std::move(data));
+        return false;
+    }
+
+    // hands the meshes over as views into the mapped cache file, returns false on a miss
+    template<class Sink>
+    bool loadFromCache(const MeshCacheKey& key, Sink& sink)
+    {
+        // shared by the meshes, the file stays mapped until the last of them is uploaded
+        auto cache = std::make_shared<MeshCache>();
+        if (!cache->Open(key))
+            return false;
+
+        cache->ReadBoneInfo(m_boneinfo_map, m_bone_counter);
+        for (uint32_t i = 0; i < cache->MeshCount(); ++i)
+        {
+            MeshData data;
+            data.mapped_vertices = cache->Vertices(i);
+            data.mapped_indices = cache->Indices(i);
+            data.mapping = cache;
+            cache->ForEachTexture(i, [&](string_view type, string_view tex_path) {
+                data.textures.push_back({ 0, string(type), string(tex_path) });
+            });
+            data.lods = cache->Lods(i);
+            sink(std::move(data));
+        }
+        return true;
+    }
+
+    // GL side: resolves the texture paths and uploads the geometry
+    void createMesh(MeshData&& data)
+    {
+        for (Texture& texture : data.textures)
+            texture = loadTexture(texture.path, texture.type);
+        meshes.emplace_back(std::move(data), m_options.format, m_options.shared_arena, m_options.residency);
+    }
+
+    // groups arena meshes by arena and texture set, one indirect command per mesh. With texture arrays the
+    // set is the arrays the textures were packed into, meshes of one size class then differ only in their layers.
+    // glMultiDrawElementsIndirect needs GL 4.3 or ARB_multi_draw_indirect, otherwise the batch is walked with base vertex draws
+    void buildBatches()
+    {
+        releaseBatches();
+        bool multi_draw = GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_multi_draw_indirect;
+        bool packed = m_options.texture_arrays && packTextures();
+        for (size_t i = 0; i < meshes.size(); ++i)
+        {
+            const Mesh& mesh = meshes[i];
+            if (!mesh.arena)
+                continue;
+            glm::ivec4 layers(-1);
+            Material material = packed ? packedMaterial(mesh, layers) : mesh.material;
+            auto same_batch = [&](const DrawBatch& batch) {
+                return batch.arena == mesh.arena && batch.material.SameTextures(material);
+            };
+            auto iter = std::find_if(m_batches.begin(), m_batches.end(), same_batch);
+            if (iter == m_batches.end())
+                iter = m_batches.insert(m_batches.end(), DrawBatch{ mesh.arena, std::move(material), {}, {} });
+            const MeshLod& level = mesh.lods[0];
+            GLuint base_instance = packed ? static_cast<GLuint>(iter->layers.size()) : 0;
+            iter->commands.push_back({ level.index_count, 1, mesh.range.first_index + level.first_index, mesh.range.base_vertex, base_instance });
+            iter->mesh_ids.push_back(i);
+            if (packed)
+                iter->layers.push_back(layers);
+        }
+        if (packed)
+            Logger::Message(std::format("texture arrays: {} meshes in {} draw batches", meshes.size(), m_batches.size()));
+
+        if (!multi_draw)
+            return;
+        for (DrawBatch& batch : m_batches)
+        {
+            glGenBuffers(1, &batch.indirect_buffer);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.indirect_buffer);
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, batch.commands.size() * sizeof(DrawElementsIndirectCommand), batch.commands.data(), GL_STATIC_DRAW);
+            if (batch.layers.empty())
+                continue;
+            glGenBuffers(1, &batch.layer_buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, batch.layer_buffer);
+            glBufferData(GL_ARRAY_BUFFER, batch.layers.size() * sizeof(glm::ivec4), batch.layers.data(), GL_STATIC_DRAW);
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void releaseBatches()
+    {
+        for (const DrawBatch& batch : m_batches)
+        {
+            if (batch.indirect_buffer)
+                glDeleteBuffers(1, &batch.indirect_buffer);
+            if (batch.layer_buffer)
+                glDeleteBuffers(1, &batch.layer_buffer);
+        }
+        m_batches.clear();
+    }
+
+    // packs every texture of the model once they are all decoded, false (and retried by Poll) until then
+    bool packTextures()
+    {
+        if (!m_texture_arrays.Empty())
+            return true;
+        m_pack_pending = !texturesDecoded();
+        if (m_pack_pending)
+            return false;
+        vector<unsigned int> ids;
+        ids.reserve(textures_loaded.size());
+        for (const Texture& texture : textures_loaded)
+            ids.push_back(texture.id);
+        m_texture_arrays.Pack(ids);
+        return true;
+    }
+
+    bool texturesDecoded() const
+    {
+        return std::none_of(textures_loaded.begin(), textures_loaded.end(),
+            [](const Texture& texture) { return TextureCache::IsPending(texture.id); });
+    }
+
+    // the arrays holding the first texture of each sampled type, layers receives the layer in each of them
+    Material packedMaterial(const Mesh& mesh, glm::ivec4& layers) const
+    {
+        static const string kSlotTypes[4] = { "texture_diffuse", "texture_specular", "texture_normal", "texture_height" };
+        vector<Texture> arrays;
+        for (int slot = 0; slot < 4; ++slot)
+        {
+            auto texture = std::find_if(mesh.textures.begin(), mesh.textures.end(),
+                [&](const Texture& t) { return t.type == kSlotTypes[slot]; });
+            if (texture == mesh.textures.end())
+                continue;
+            TextureLayer packed = m_texture_arrays.Find(texture->id);
+            if (!packed.array)
+                continue;
+            layers[slot] = packed.layer;
+            arrays.push_back({ packed.array, kSlotTypes[slot] + "_array", "" });
+        }
+        return Material(arrays, GL_TEXTURE_2D_ARRAY);
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode* node, const aiScene* scene)
+    template<class Func>
+    void processNode(aiNode* node, const aiScene* scene, Func&& func)
     {
         // process each mesh located at the current node
         for (unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -84,22 +524,24 @@ private:
             // the node object only contains indices to index the actual objects in the scene. 
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            func(processMesh(mesh, scene));
         }
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for (unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, func);
         }
 
     }
 
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene)
+    MeshData processMesh(aiMesh* mesh, const aiScene* scene)
     {
         // data to fill
         vector<Vertex> vertices;
         vector<unsigned int> indices;
         vector<Texture> textures;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
 
         // walk through each of the mesh's vertices
         for (unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -154,11 +596,20 @@ private:
         // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
         for (unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace& face = mesh->mFaces[i];
             // retrieve all indices of the face and store them in the indices vector
             for (unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);
         }
+        if (m_options.optimize)
+        {
+            auto [before, after] = OptimizeMesh(vertices, indices);
+            Logger::Message(std::format("optimized mesh {} - {} tris, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+                mesh->mName.C_Str(), indices.size() / 3, before.acmr, after.acmr, before.atvr, after.atvr));
+        }
+        vector<MeshLod> lods;
+        if (m_options.lods)
+            lods = buildLods(vertices, indices, mesh->mName.C_Str());
         // process materials
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
@@ -181,11 +632,37 @@ private:
         std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        // return the extracted mesh data, it becomes a Mesh on the GL thread
+        return MeshData{ std::move(vertices), std::move(indices), std::move(textures), std::move(lods) };
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
+    // appends up to kMaxMeshLods - 1 simplified index lists after the base ones, each aiming at half the
+    // triangles of the previous. Errors accumulate so every level knows its deviation from the base mesh.
+    vector<MeshLod> buildLods(const vector<Vertex>& vertices, vector<unsigned int>& indices, const char* name)
+    {
+        vector<MeshLod> lods{ { 0, static_cast<unsigned int>(indices.size()), 0.0f } };
+        float extent = MeshExtent(vertices);
+        vector<unsigned int> previous = indices;
+        string report;
+        for (size_t level = 1; level < kMaxMeshLods; ++level)
+        {
+            float error = 0.0f;
+            vector<unsigned int> lod = SimplifyMesh(previous, vertices, previous.size() / 6 * 3, kLodStepMaxError, &error);
+            // stop once locked borders and seams keep the mesh from shrinking further
+            if (lod.empty() || lod.size() > previous.size() * 3 / 4)
+                break;
+            if (m_options.optimize)
+                OptimizeVertexCache(lod, vertices.size());
+            lods.push_back({ static_cast<unsigned int>(indices.size()), static_cast<unsigned int>(lod.size()), lods.back().error + error * extent });
+            indices.insert(indices.end(), lod.begin(), lod.end());
+            report += std::format(" -> {}", lod.size() / 3);
+            previous = std::move(lod);
+        }
+        Logger::Message(std::format("mesh {} lods: {}{} tris", name, lods[0].index_count / 3, report));
+        return lods;
+    }
+
+    // collects all material textures of a given type, createMesh loads them later.
     // the required info is returned as a Texture struct.
     vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName)
     {
@@ -194,29 +671,26 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for (unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if (!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            textures.push_back({ 0, typeName, str.C_Str() });
         }
         return textures;
     }
+
+    Texture loadTexture(const string& path, const string& typeName)
+    {
+        // check if texture was loaded before and if so, skip loading a new texture
+        if (auto iter = m_texture_lookup.find(path); iter != m_texture_lookup.end())
+            return textures_loaded[iter->second]; // a texture with the same filepath has already been loaded. (optimization)
+
+        // otherwise take a reference from the process wide cache, its image is decoded by TextureCache::Flush
+        Texture texture;
+        texture.id = TextureCache::Acquire(this->directory + '/' + path, gammaCorrection);
+        texture.type = typeName;
+        texture.path = path;
+        m_texture_lookup.emplace(path, textures_loaded.size());
+        textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
+        return texture;
+    }
     
     void SetVertexBoneDataToDefault(Vertex& vertex) {
         for (int i = 0; i < MAX_BONE_INFLUENCE; ++i) {
@@ -278,35 +752,10 @@ unsigned int TextureFromFile(const char* path, const string& directory, bool gam
     unsigned int textureID = 0;
     glGenTextures(1, &textureID);
 
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
+    TextureImage image = DecodeTextureImage(filename);
+    UploadTextureImage(textureID, image, path);
 
     return textureID;
 }
+
 #endif
\ No newline at end of file
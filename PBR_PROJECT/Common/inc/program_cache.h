@@ -0,0 +1,138 @@
+#ifndef __PROGRAM_CACHE_H
+#define __PROGRAM_CACHE_H
+
+#include "hash_utils.h"
+#include "mapped_file.h"
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef SHADER_CACHE_DIR
+#define SHADER_CACHE_DIR "shader_cache"
+#endif
+
+// On-disk cache of linked programs (glGetProgramBinary / glProgramBinary).
+// One file per program name and define set:  header | driver specific binary
+// The content hash covers the sources, the defines and the driver identity, so an edited
+// shader or an updated driver is a miss and the file is rewritten after the next link.
+constexpr uint32_t kProgramCacheMagic	= 0x4E42504C;	// "LPBN"
+constexpr uint32_t kProgramCacheVersion = 1;
+
+struct ProgramCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t name_hash;
+	uint64_t content_hash;
+	uint32_t binary_format;
+	uint32_t binary_size;
+};
+
+struct ProgramCacheKey {
+	uint64_t name_hash	  = 0;
+	uint64_t content_hash = 0;
+};
+
+class ProgramCache {
+public:
+	// program binaries need GL 4.1 or ARB_get_program_binary and at least one binary format
+	static bool Supported() {
+		static const bool supported = [] {
+			if (!(GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary)) return false;
+			GLint formats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+			return formats > 0;
+		}();
+		return supported;
+	}
+
+	// name identifies the cache file (e.g. the shader paths), sources are the exact strings handed to the compiler
+	static ProgramCacheKey MakeKey(std::string_view name, std::initializer_list<std::string_view> sources, std::string_view defines = {}) {
+		ProgramCacheKey key;
+		key.name_hash = HashString(defines, HashString(name));
+		uint64_t hash = key.name_hash;
+		for (std::string_view source : sources) {
+			hash = HashValue(source.size(), hash);
+			hash = HashString(source, hash);
+		}
+		for (GLenum id : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+			const GLubyte* str = glGetString(id);
+			if (str) hash = HashString(reinterpret_cast<const char*>(str), hash);
+		}
+		key.content_hash = hash;
+		return key;
+	}
+
+	static std::filesystem::path CachePath(const ProgramCacheKey& key) {
+		return std::filesystem::path(SHADER_CACHE_DIR) / std::format("{:016x}.progbin", key.name_hash);
+	}
+
+	// loads a cached binary into program, false when there is none or the driver rejects it.
+	// A rejected program is left unlinked, the caller should start over with a fresh one
+	static bool Load(GLuint program, const ProgramCacheKey& key) {
+		if (!Supported()) return false;
+		MappedFile file(CachePath(key).string());
+		if (!file.IsOpen() || file.Size() < sizeof(ProgramCacheHeader)) return false;
+
+		const ProgramCacheHeader* header = reinterpret_cast<const ProgramCacheHeader*>(file.Data());
+		if (header->magic		 != kProgramCacheMagic	 ||
+			header->version		 != kProgramCacheVersion ||
+			header->name_hash	 != key.name_hash		 ||
+			header->content_hash != key.content_hash	 ||
+			header->binary_size	 >  file.Size() - sizeof(ProgramCacheHeader)) {
+			return false;
+		}
+
+		glProgramBinary(program, header->binary_format, file.Data() + sizeof(ProgramCacheHeader), header->binary_size);
+		GLint linked = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		return linked == GL_TRUE;
+	}
+
+	// writes the binary of a successfully linked program, linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+	static bool Store(GLuint program, const ProgramCacheKey& key) {
+		if (!Supported()) return false;
+		GLint linked = GL_FALSE, length = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (linked != GL_TRUE || length <= 0) return false;
+
+		std::vector<char> binary(static_cast<size_t>(length));
+		GLenum format = 0;
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+		if (length <= 0) return false;
+
+		ProgramCacheHeader header{
+			.magic		   = kProgramCacheMagic,
+			.version	   = kProgramCacheVersion,
+			.name_hash	   = key.name_hash,
+			.content_hash  = key.content_hash,
+			.binary_format = format,
+			.binary_size   = static_cast<uint32_t>(length),
+		};
+
+		std::error_code ec;
+		std::filesystem::path path = CachePath(key);
+		std::filesystem::create_directories(path.parent_path(), ec);
+		std::filesystem::path tmp_path = path;
+		tmp_path += ".tmp";
+		{
+			std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+			if (!out.is_open()) return false;
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(binary.data(), length);
+			if (!out.good()) return false;
+		}
+		std::filesystem::rename(tmp_path, path, ec);
+		return !ec;
+	}
+};
+
+#endif // !__PROGRAM_CACHE_H
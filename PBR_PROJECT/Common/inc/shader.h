@@ -4,167 +4,558 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "hash_utils.h"
+#include "gl_state.h"
+#include "logger.h"
+#include "program_cache.h"
+#include "uniform_buffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// glUniform* for each supported C++ type, count > 1 writes consecutive array elements
+inline void UploadUniform(GLint location, GLsizei count, const int* value)       { glUniform1iv(location, count, value); }
+inline void UploadUniform(GLint location, GLsizei count, const float* value)     { glUniform1fv(location, count, value); }
+inline void UploadUniform(GLint location, GLsizei count, const glm::vec2* value) { glUniform2fv(location, count, &(*value)[0]); }
+inline void UploadUniform(GLint location, GLsizei count, const glm::vec3* value) { glUniform3fv(location, count, &(*value)[0]); }
+inline void UploadUniform(GLint location, GLsizei count, const glm::vec4* value) { glUniform4fv(location, count, &(*value)[0]); }
+inline void UploadUniform(GLint location, GLsizei count, const glm::mat2* value) { glUniformMatrix2fv(location, count, GL_FALSE, &(*value)[0][0]); }
+inline void UploadUniform(GLint location, GLsizei count, const glm::mat3* value) { glUniformMatrix3fv(location, count, GL_FALSE, &(*value)[0][0]); }
+inline void UploadUniform(GLint location, GLsizei count, const glm::mat4* value) { glUniformMatrix4fv(location, count, GL_FALSE, &(*value)[0][0]); }
+
+// bools have no glUniform*v of their own, they go up as ints
+inline void UploadUniform(GLint location, GLsizei count, const bool* value)
+{
+    if (count == 1)
+    {
+        glUniform1i(location, static_cast<GLint>(*value));
+        return;
+    }
+    std::vector<GLint> ints(value, value + count);
+    glUniform1iv(location, count, ints.data());
+}
+
+// GL type a C++ type is uploaded as, 0 accepts anything glUniform1i takes (ints, bools, samplers)
+template<class T> constexpr GLenum kUniformType = 0;
+template<> constexpr GLenum kUniformType<float>     = GL_FLOAT;
+template<> constexpr GLenum kUniformType<glm::vec2> = GL_FLOAT_VEC2;
+template<> constexpr GLenum kUniformType<glm::vec3> = GL_FLOAT_VEC3;
+template<> constexpr GLenum kUniformType<glm::vec4> = GL_FLOAT_VEC4;
+template<> constexpr GLenum kUniformType<glm::mat2> = GL_FLOAT_MAT2;
+template<> constexpr GLenum kUniformType<glm::mat3> = GL_FLOAT_MAT3;
+template<> constexpr GLenum kUniformType<glm::mat4> = GL_FLOAT_MAT4;
+
+// pre-resolved uniform of a linked program, setting it is a single glUniform* call.
+// The owning program must be in use, an unresolved handle (location -1) is ignored by GL.
+template<class T>
+struct Uniform {
+    GLint location = -1;
+    GLint count    = 1;     // elements when resolved from an array
+
+    void set(const T& value) const
+    {
+        UploadUniform(location, 1, &value);
+    }
+
+    // uploads the whole array in one call, clamped to the declared length
+    void set(std::span<const T> values) const
+    {
+        GLsizei n = static_cast<GLsizei>(std::min<size_t>(values.size(), count));
+        if (n > 0)
+            UploadUniform(location, n, values.data());
+    }
+
+    explicit operator bool() const { return location >= 0; }
+};
+
+// the files of one program as read from disk, shared by all of its permutations
+struct ShaderSource {
+    std::string name;       // the paths, identifies the program in the binary cache
+    std::string label;      // file names, for logs
+    std::string vertex_path;
+    std::string fragment_path;
+    std::string geometry_path;
+    std::string vertex;
+    std::string fragment;
+    std::string geometry;
+    bool        has_geometry = false;
+    uint64_t    hash         = 0;
+
+    static ShaderSource Load(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    {
+        ShaderSource source;
+        source.name  = std::format("{}|{}|{}", vertexPath, fragmentPath, geometryPath ? geometryPath : "");
+        source.label = std::format("{}, {}", std::filesystem::path(vertexPath).filename().string(), std::filesystem::path(fragmentPath).filename().string());
+        source.vertex_path   = vertexPath;
+        source.fragment_path = fragmentPath;
+        source.geometry_path = geometryPath ? geometryPath : "";
+        source.vertex   = ReadFile(vertexPath);
+        source.fragment = ReadFile(fragmentPath);
+        source.has_geometry = geometryPath != nullptr;
+        if (source.has_geometry)
+            source.geometry = ReadFile(geometryPath);
+        source.hash = HashString(source.geometry, HashString(source.fragment, HashString(source.vertex, HashString(source.name))));
+        return source;
+    }
+
+    // the same files read again, e.g. after an edit
+    ShaderSource reread() const
+    {
+        return Load(vertex_path.c_str(), fragment_path.c_str(), has_geometry ? geometry_path.c_str() : nullptr);
+    }
+
+    static std::string ReadFile(const char* path)
+    {
+        std::ifstream file;
+        // ensure ifstream objects can throw exceptions:
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            file.open(path);
+            std::stringstream stream;
+            stream << file.rdbuf();
+            file.close();
+            return stream.str();
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << " " << e.what() << std::endl;
+        }
+        return {};
+    }
+};
 
 class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+
+    // active uniform as reported by glGetActiveUniform
+    struct UniformInfo {
+        GLint  location;
+        GLenum type;
+        GLint  size;        // array length, 1 for plain uniforms
+    };
+    // constructor generates the shader on the fly, defines are injected right after #version
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
-    {
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        try
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr, std::span<const std::string_view> defines = {})
+        : Shader(ShaderSource::Load(vertexPath, fragmentPath, geometryPath), defines)
+    {
+    }
+
+    // builds one permutation of sources that were already read, see ShaderVariants
+    Shader(const ShaderSource& source, std::span<const std::string_view> defines = {})
+        : m_source(source)
+    {
+        for (std::string_view define : defines)
+            m_defines.append(define).push_back(';');
+        std::string vertexCode   = InjectDefines(source.vertex, defines);
+        std::string fragmentCode = InjectDefines(source.fragment, defines);
+        std::string geometryCode = source.has_geometry ? InjectDefines(source.geometry, defines) : std::string();
+
+        // reuse the program linked by an earlier run, compile from source when there is none or the driver rejects it
+        ProgramCacheKey key = ProgramCache::MakeKey(source.name, { vertexCode, fragmentCode, geometryCode }, m_defines);
+        auto start = std::chrono::steady_clock::now();
+        ID = glCreateProgram();
+        bool hit = ProgramCache::Load(ID, key);
+        if (!hit)
         {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-            // if geometry shader path is present, also load a geometry shader
-            if (geometryPath != nullptr)
-            {
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
+            glDeleteProgram(ID);
+            PendingProgram pending = startProgram(vertexCode, fragmentCode, source.has_geometry ? &geometryCode : nullptr);
+            ID = pending.program;
+            finishProgram(pending);
+            ProgramCache::Store(ID, key);
         }
-        catch (std::ifstream::failure& e)
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        Logger::Message(std::format("program {} ({}{}{}) {} in {:.2f} ms", ID, source.label,
+            m_defines.empty() ? "" : " ", m_defines, hit ? "loaded from cache" : "compiled", ms));
+
+        BindUniformBlocks(ID);
+        reflectUniforms();
+    }
+
+    // the program itself is left to the context, which may already be gone for static shaders
+    ~Shader()
+    {
+        retireSerial();
+    }
+
+    Shader(const Shader&)            = delete;
+    Shader& operator=(const Shader&) = delete;
+
+    const ShaderSource& source() const { return m_source; }
+
+    // changes whenever ID names a newly linked program, unlike ID it is never handed out twice.
+    // Lets state resolved against a program (see Material) notice a reload
+    uint64_t serial() const { return m_serial; }
+
+    // a serial is retired when its program is relinked by a reload or its Shader is destroyed.
+    // retiredCount() changes with every retirement, so state keyed by serial can tell cheaply when
+    // to look for entries to drop
+    static bool     isLive(uint64_t serial) { return liveSerials().contains(serial); }
+    static uint64_t retiredCount()          { return s_retired_count; }
+
+    // hot reload: reads the files again and compiles them into a second program while ID stays usable.
+    // With KHR_parallel_shader_compile the driver works in the background and pollReload never waits on it
+    void reload()
+    {
+        discardReload();
+        ShaderSource source = m_source.reread();
+        // caught in the middle of a save, the write that completes it triggers another reload
+        if (source.vertex.empty() || source.fragment.empty() || (source.has_geometry && source.geometry.empty()))
+            return;
+        m_source = std::move(source);
+
+        std::vector<std::string_view> defines;
+        for (size_t begin = 0, end; (end = m_defines.find(';', begin)) != std::string::npos; begin = end + 1)
+            defines.push_back(std::string_view(m_defines).substr(begin, end - begin));
+        std::string vertexCode   = InjectDefines(m_source.vertex, defines);
+        std::string fragmentCode = InjectDefines(m_source.fragment, defines);
+        std::string geometryCode = m_source.has_geometry ? InjectDefines(m_source.geometry, defines) : std::string();
+
+        ParallelCompile();
+        m_pending     = startProgram(vertexCode, fragmentCode, m_source.has_geometry ? &geometryCode : nullptr);
+        m_pending.key = ProgramCache::MakeKey(m_source.name, { vertexCode, fragmentCode, geometryCode }, m_defines);
+    }
+
+    // finishes a reload once the driver is done. Returns true when ID now names the new program;
+    // a failed compile or link is logged and the previous program stays in use
+    bool pollReload()
+    {
+        if (m_pending.program == 0)
+            return false;
+        if (ParallelCompile())
         {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << e.what() << std::endl;
+            GLint done = GL_FALSE;
+            glGetProgramiv(m_pending.program, GL_COMPLETION_STATUS_KHR, &done);
+            if (done != GL_TRUE)
+                return false;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);        
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);        
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
-        if (geometryPath != nullptr)
+
+        PendingProgram pending = std::exchange(m_pending, PendingProgram{});
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - pending.start).count();
+        if (!finishProgram(pending))
         {
-            const char* gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
+            Logger::Warning(std::format("reload of ({}{}{}) failed, keeping program {}", m_source.label,
+                m_defines.empty() ? "" : " ", m_defines, ID));
+            glDeleteProgram(pending.program);
+            return false;
         }
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if (geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessery
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if (geometryPath != nullptr)
-            glDeleteShader(geometry);
+        glDeleteProgram(ID);
+        GLState::ForgetProgram(ID);
+        ID = pending.program;
+        BindUniformBlocks(ID);
+        reflectUniforms();
+        ProgramCache::Store(ID, pending.key);
+        Logger::Message(std::format("program {} ({}{}{}) reloaded in {:.2f} ms", ID, m_source.label,
+            m_defines.empty() ? "" : " ", m_defines, ms));
+        return true;
+    }
+
+    bool reloading() const { return m_pending.program != 0; }
+
+    // drops a reload in flight, the current program is untouched
+    void discardReload()
+    {
+        if (m_pending.program == 0)
+            return;
+        finishProgram(m_pending, false);
+        glDeleteProgram(m_pending.program);
+        m_pending = {};
+    }
+
+    // asks the driver for background compiler threads once, false when it cannot report completion
+    static bool ParallelCompile()
+    {
+        static const bool supported = [] {
+            if (GLAD_GL_KHR_parallel_shader_compile)
+                glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+            else if (GLAD_GL_ARB_parallel_shader_compile)
+                glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+            else
+                return false;
+            return true;
+        }();
+        return supported;
+    }
+
+    // "#define NAME" or "#define NAME VALUE" lines after the #version directive (which has to stay first),
+    // followed by a #line so compile errors still point at the lines of the file
+    static std::string InjectDefines(const std::string& code, std::span<const std::string_view> defines)
+    {
+        if (defines.empty())
+            return code;
+        size_t version = code.find("#version");
+        size_t insert  = version == std::string::npos ? 0 : code.find('\n', version);
+        insert = insert == std::string::npos ? code.size() : insert + 1;
+        size_t line = static_cast<size_t>(std::count(code.begin(), code.begin() + insert, '\n'));
 
+        std::string result;
+        result.reserve(code.size() + defines.size() * 32 + 16);
+        result.append(code, 0, insert);
+        if (insert > 0 && result.back() != '\n')
+            result.push_back('\n');
+        for (std::string_view define : defines)
+            result.append("#define ").append(define).push_back('\n');
+        result.append(std::format("#line {}\n", line + 1));
+        result.append(code, insert, std::string::npos);
+        return result;
     }
+
     // activate the shader
     // ------------------------------------------------------------------------
     void use()
     {
-        glUseProgram(ID);
+        GLState::UseProgram(ID);
+    }
+    // location of an active uniform ("name", "name[i]" for array elements), -1 when inactive.
+    // a hashed lookup into the table built at link time, the driver is never asked
+    GLint location(std::string_view name) const
+    {
+        auto iter = m_uniforms.find(name);
+        return iter != m_uniforms.end() ? iter->second.location : -1;
+    }
+
+    const UniformInfo* uniformInfo(std::string_view name) const
+    {
+        auto iter = m_uniforms.find(name);
+        return iter != m_uniforms.end() ? &iter->second : nullptr;
+    }
+
+    // fn(name, info) for every active uniform, arrays are visited under each of their names
+    template<class Func>
+    void forEachUniform(Func&& fn) const
+    {
+        for (const auto& [name, info] : m_uniforms)
+            fn(std::string_view(name), info);
+    }
+
+    // resolves a typed handle once, for loops that run every frame. Warns when the uniform is missing
+    // (e.g. optimized out) or declared with another type
+    template<class T>
+    Uniform<T> getUniform(std::string_view name) const
+    {
+        const UniformInfo* info = uniformInfo(name);
+        if (!info)
+        {
+            Logger::Warning(std::format("shader {} has no active uniform {}", ID, name));
+            return {};
+        }
+        if (kUniformType<T> != 0 && info->type != kUniformType<T>)
+            Logger::Warning(std::format("shader {} uniform {} is not of the requested type", ID, name));
+        return { info->location, info->size };
     }
+
     // utility uniform functions
     // ------------------------------------------------------------------------
-    void setBool(const std::string& name, bool value) const
+    void setBool(std::string_view name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        glUniform1i(location(name), (int)value);
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string& name, int value) const
+    void setInt(std::string_view name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(location(name), value);
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string& name, float value) const
+    void setFloat(std::string_view name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(location(name), value);
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string& name, const glm::vec2& value) const
+    void setVec2(std::string_view name, const glm::vec2& value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform2fv(location(name), 1, &value[0]);
     }
-    void setVec2(const std::string& name, float x, float y) const
+    void setVec2(std::string_view name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        glUniform2f(location(name), x, y);
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string& name, const glm::vec3& value) const
+    void setVec3(std::string_view name, const glm::vec3& value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform3fv(location(name), 1, &value[0]);
     }
-    void setVec3(const std::string& name, float x, float y, float z) const
+    void setVec3(std::string_view name, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        glUniform3f(location(name), x, y, z);
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string& name, const glm::vec4& value) const
+    void setVec4(std::string_view name, const glm::vec4& value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        glUniform4fv(location(name), 1, &value[0]);
     }
-    void setVec4(const std::string& name, float x, float y, float z, float w)
+    void setVec4(std::string_view name, float x, float y, float z, float w)
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        glUniform4f(location(name), x, y, z, w);
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string& name, const glm::mat2& mat) const
+    void setMat2(std::string_view name, const glm::mat2& mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string& name, const glm::mat3& mat) const
+    void setMat3(std::string_view name, const glm::mat3& mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string& name, const glm::mat4& mat) const
+    void setMat4(std::string_view name, const glm::mat4& mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
+    // transparent hashing so lookups by string_view do not build a std::string
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return static_cast<size_t>(HashString(name)); }
+    };
+    std::unordered_map<std::string, UniformInfo, NameHash, std::equal_to<>> m_uniforms;
+    uint64_t m_serial = 0;
+    static inline uint64_t s_next_serial = 0;
+    static inline uint64_t s_retired_count = 0;
+
+    // never destroyed, shaders with static storage retire their serial during exit
+    static std::unordered_set<uint64_t>& liveSerials()
+    {
+        static auto* serials = new std::unordered_set<uint64_t>();
+        return *serials;
+    }
+
+    void retireSerial()
+    {
+        if (m_serial == 0)
+            return;
+        liveSerials().erase(m_serial);
+        ++s_retired_count;
+    }
+
+    // records every active uniform of the linked program. Arrays are reported as "name[0]" and are
+    // registered under "name" and each "name[i]" so both spellings resolve
+    void reflectUniforms()
+    {
+        retireSerial();
+        m_serial = ++s_next_serial;
+        liveSerials().insert(m_serial);
+        m_uniforms.clear();
+        GLint count = 0, max_length = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+        std::string name(std::max(max_length, 1), '\0');
+        for (GLint i = 0; i < count; ++i)
+        {
+            GLsizei length = 0;
+            GLint   size   = 0;
+            GLenum  type   = 0;
+            glGetActiveUniform(ID, static_cast<GLuint>(i), max_length, &length, &size, &type, name.data());
+            std::string uniform(name.data(), length);
+            GLint loc = glGetUniformLocation(ID, uniform.c_str());
+            // uniform block members have no location and are not set through glUniform*
+            if (loc < 0)
+                continue;
+            m_uniforms[uniform] = { loc, type, size };
+            if (!uniform.ends_with("[0]"))
+                continue;
+            std::string base = uniform.substr(0, uniform.size() - 3);
+            m_uniforms[base] = { loc, type, size };
+            for (GLint e = 1; e < size; ++e)
+            {
+                std::string element = std::format("{}[{}]", base, e);
+                m_uniforms[element] = { glGetUniformLocation(ID, element.c_str()), type, size - e };
+            }
+        }
+    }
+
+    // a program whose stages were submitted but whose status was not queried yet.
+    // Asking for compile or link status blocks until the driver is done, so that is left to finishProgram
+    struct PendingProgram {
+        GLuint program  = 0;
+        GLuint vertex   = 0;
+        GLuint fragment = 0;
+        GLuint geometry = 0;
+        ProgramCacheKey key;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    };
+
+    // what the program was built from, kept for reloads
+    ShaderSource   m_source;
+    std::string    m_defines;   // "A;B 1;"
+    PendingProgram m_pending;
+
+    // compiles the stages and links them into a new program, asking for a binary the program cache can keep
+    static PendingProgram startProgram(const std::string& vertexCode, const std::string& fragmentCode, const std::string* geometryCode)
+    {
+        PendingProgram pending;
+        const char* vShaderCode = vertexCode.c_str();
+        const char* fShaderCode = fragmentCode.c_str();
+        // vertex shader
+        pending.vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(pending.vertex, 1, &vShaderCode, NULL);
+        glCompileShader(pending.vertex);
+        // fragment Shader
+        pending.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(pending.fragment, 1, &fShaderCode, NULL);
+        glCompileShader(pending.fragment);
+        // if geometry shader is given, compile geometry shader
+        if (geometryCode != nullptr)
+        {
+            const char* gShaderCode = geometryCode->c_str();
+            pending.geometry = glCreateShader(GL_GEOMETRY_SHADER);
+            glShaderSource(pending.geometry, 1, &gShaderCode, NULL);
+            glCompileShader(pending.geometry);
+        }
+        // shader Program
+        pending.program = glCreateProgram();
+        glAttachShader(pending.program, pending.vertex);
+        glAttachShader(pending.program, pending.fragment);
+        if (pending.geometry != 0)
+            glAttachShader(pending.program, pending.geometry);
+        if (ProgramCache::Supported())
+            glProgramParameteri(pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(pending.program);
+        return pending;
+    }
+
+    // reports errors and releases the stages, returns the link status
+    static bool finishProgram(PendingProgram& pending, bool report = true)
+    {
+        GLint linked = GL_FALSE;
+        if (report)
+        {
+            checkCompileErrors(pending.vertex, "VERTEX");
+            checkCompileErrors(pending.fragment, "FRAGMENT");
+            if (pending.geometry != 0)
+                checkCompileErrors(pending.geometry, "GEOMETRY");
+            checkCompileErrors(pending.program, "PROGRAM");
+            glGetProgramiv(pending.program, GL_LINK_STATUS, &linked);
+        }
+        // delete the shaders as they're linked into our program now and no longer necessery
+        glDeleteShader(pending.vertex);
+        glDeleteShader(pending.fragment);
+        if (pending.geometry != 0)
+            glDeleteShader(pending.geometry);
+        pending.vertex = pending.fragment = pending.geometry = 0;
+        return linked == GL_TRUE;
+    }
+
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
-    void checkCompileErrors(GLuint shader, std::string type)
+    static void checkCompileErrors(GLuint shader, std::string type)
     {
         GLint success;
         GLchar infoLog[1024];
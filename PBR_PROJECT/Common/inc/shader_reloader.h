@@ -0,0 +1,83 @@
+#ifndef __SHADER_RELOADER_H
+#define __SHADER_RELOADER_H
+
+#include "custom_macro.h"
+#include "shader.h"
+#include "shader_watcher.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Live editing of shader files. Watched programs are recompiled when one of their files is written;
+// the new program replaces the old one only after it linked, so a typo leaves the last good version on
+// screen. Everything happens on the GL thread from Update, once per frame.
+class ShaderReloader {
+
+	NoConstructor(ShaderReloader)
+
+public:
+	// called with the reloaded program in use, for per program state (sampler units, Uniform<T> handles)
+	using ReloadCallback = std::function<void(Shader&)>;
+
+	// shader has to stay alive for as long as it is watched: a static or one owned by ShaderVariants
+	static bool Watch(Shader& shader, ReloadCallback on_reload = {}) {
+		State& state = Instance();
+		Entry entry{ &shader, std::move(on_reload), {} };
+		const ShaderSource& source = shader.source();
+		entry.files.push_back(state.watcher.Watch(source.vertex_path));
+		entry.files.push_back(state.watcher.Watch(source.fragment_path));
+		if (source.has_geometry) entry.files.push_back(state.watcher.Watch(source.geometry_path));
+		state.entries.push_back(std::move(entry));
+		return true;
+	}
+
+	static void Unwatch(Shader& shader) {
+		State& state = Instance();
+		shader.discardReload();
+		std::erase_if(state.entries, [&](const Entry& entry) { return entry.shader == &shader; });
+	}
+
+	// starts recompiling programs whose files changed and swaps in the ones that finished
+	static void Update() {
+		State& state = Instance();
+		std::vector<std::filesystem::path> changed = state.watcher.Poll();
+		if (!changed.empty()) ++state.generation;
+		for (Entry& entry : state.entries) {
+			bool affected = std::any_of(entry.files.begin(), entry.files.end(), [&](const std::filesystem::path& file) {
+				return std::find(changed.begin(), changed.end(), file) != changed.end();
+			});
+			if (affected) entry.shader->reload();
+			if (entry.shader->reloading() && entry.shader->pollReload() && entry.on_reload) {
+				entry.shader->use();
+				entry.on_reload(*entry.shader);
+			}
+		}
+	}
+
+	// bumped whenever a watched file changes, lets owners of cached sources know they are stale
+	static uint64_t Generation() { return Instance().generation; }
+
+private:
+	struct Entry {
+		Shader*							   shader;
+		ReloadCallback					   on_reload;
+		std::vector<std::filesystem::path> files;
+	};
+
+	struct State {
+		ShaderWatcher	   watcher;
+		std::vector<Entry> entries;
+		uint64_t		   generation = 0;
+	};
+
+	static State& Instance() {
+		static State state;
+		return state;
+	}
+};
+
+#endif // !__SHADER_RELOADER_H
@@ -0,0 +1,79 @@
+#ifndef __SHADER_VARIANTS_H
+#define __SHADER_VARIANTS_H
+
+#include "shader.h"
+#include "shader_reloader.h"
+#include "hash_utils.h"
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+// All permutations of one program. The sources are read once, a variant is compiled (or loaded from
+// the program cache) the first time its define set is requested and kept from then on, so switching
+// between variants that were already built is a hash lookup. Every variant is watched by ShaderReloader
+// and rebuilt in place when the files change.
+class ShaderVariants {
+public:
+	// called with the new variant in use, for state that is fixed per program such as sampler units
+	using BuildCallback = std::function<void(Shader&)>;
+
+	ShaderVariants(const char* vertex_path, const char* fragment_path, const char* geometry_path = nullptr, BuildCallback on_build = {})
+		: source_(ShaderSource::Load(vertex_path, fragment_path, geometry_path)),
+		  key_seed_(source_.hash),
+		  generation_(ShaderReloader::Generation()),
+		  on_build_(std::move(on_build)) {}
+
+	ShaderVariants(const ShaderVariants&)			 = delete;
+	ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+	// the variant with exactly these defines, built on first request
+	Shader& Get(std::span<const std::string_view> defines) {
+		uint64_t key = Key(defines);
+		auto iter = variants_.find(key);
+		if (iter != variants_.end()) return *iter->second;
+
+		// files edited since they were read, a new variant should not resurrect the old code
+		if (generation_ != ShaderReloader::Generation()) {
+			source_		= source_.reread();
+			generation_ = ShaderReloader::Generation();
+		}
+		auto shader = std::make_unique<Shader>(source_, defines);
+		if (on_build_) {
+			shader->use();
+			on_build_(*shader);
+		}
+		ShaderReloader::Watch(*shader, on_build_);
+		return *variants_.emplace(key, std::move(shader)).first->second;
+	}
+
+	Shader& Get(std::initializer_list<std::string_view> defines) {
+		return Get(std::span<const std::string_view>(defines.begin(), defines.size()));
+	}
+
+	inline const ShaderSource& Source() const { return source_; }
+	inline size_t			   Size()	const { return variants_.size(); }
+
+private:
+	// keyed by (source hash, define set), the define hashes are summed so their order does not matter.
+	// The source hash is the one at construction, reloaded variants keep their slot
+	uint64_t Key(std::span<const std::string_view> defines) const {
+		uint64_t sum = 0;
+		for (std::string_view define : defines) sum += HashString(define);
+		return HashValue(sum, key_seed_);
+	}
+
+private:
+	ShaderSource  source_;
+	uint64_t	  key_seed_;
+	uint64_t	  generation_;
+	BuildCallback on_build_;
+	std::unordered_map<uint64_t, std::unique_ptr<Shader>> variants_;
+};
+
+#endif // !__SHADER_VARIANTS_H
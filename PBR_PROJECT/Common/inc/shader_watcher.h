@@ -0,0 +1,49 @@
+#ifndef __SHADER_WATCHER_H
+#define __SHADER_WATCHER_H
+
+#include <chrono>
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+// Reports edits to a set of files. On Linux the directories holding them are watched with inotify,
+// elsewhere (or when inotify is unavailable) modification times are compared every kScanInterval.
+// Poll never blocks, it is meant to be called once per frame.
+class ShaderWatcher {
+public:
+	static constexpr std::chrono::milliseconds kScanInterval{ 500 };
+
+	ShaderWatcher();
+	~ShaderWatcher();
+
+	ShaderWatcher(const ShaderWatcher&)			   = delete;
+	ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+	// starts watching file (and its directory), returns the normalised path Poll reports it as
+	std::filesystem::path Watch(const std::filesystem::path& file);
+
+	// watched files written since the last call, each reported once
+	std::vector<std::filesystem::path> Poll();
+
+	inline bool UsesNotifications() const { return fd_ >= 0; }
+
+	static std::filesystem::path Normalize(const std::filesystem::path& path);
+
+private:
+	struct File {
+		std::filesystem::path			path;
+		std::filesystem::file_time_type time;
+	};
+
+	void PollNotifications(std::vector<std::filesystem::path>& changed);
+	void Scan(std::vector<std::filesystem::path>& changed);
+	static std::filesystem::file_time_type WriteTime(const std::filesystem::path& path);
+
+private:
+	std::vector<File> files_;
+	std::vector<std::pair<int, std::filesystem::path>> dirs_;	// watch descriptor, directory
+	int fd_ = -1;
+	std::chrono::steady_clock::time_point next_scan_;
+};
+
+#endif // !__SHADER_WATCHER_H
@@ -0,0 +1,74 @@
+#ifndef __SIMD_FLOAT_H
+#define __SIMD_FLOAT_H
+
+#include <cmath>
+
+// widest float vector the build targets: AVX (/arch:AVX, -mavx) gives 8 lanes, SSE2 (any x64 build) 4,
+// anything else falls back to one plain float so the same code still compiles
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SIMD_FLOAT_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_FLOAT_SSE
+#endif
+
+// Lane-wise float math for structure-of-arrays loops. Load and Store expect kAlign aligned pointers.
+// Wrapped in a struct because MSVC has no arithmetic operators on the raw intrinsic types
+struct SimdFloat {
+#if defined(SIMD_FLOAT_AVX)
+	static constexpr int kWidth = 8;
+	__m256 v;
+
+	static SimdFloat Load(const float* ptr)	{ return { _mm256_load_ps(ptr) }; }
+	static SimdFloat Splat(float value)		{ return { _mm256_set1_ps(value) }; }
+	void Store(float* ptr) const			{ _mm256_store_ps(ptr, v); }
+
+	friend SimdFloat operator+(SimdFloat a, SimdFloat b) { return { _mm256_add_ps(a.v, b.v) }; }
+	friend SimdFloat operator-(SimdFloat a, SimdFloat b) { return { _mm256_sub_ps(a.v, b.v) }; }
+	friend SimdFloat operator*(SimdFloat a, SimdFloat b) { return { _mm256_mul_ps(a.v, b.v) }; }
+	friend SimdFloat operator/(SimdFloat a, SimdFloat b) { return { _mm256_div_ps(a.v, b.v) }; }
+	friend SimdFloat Sqrt(SimdFloat a)					 { return { _mm256_sqrt_ps(a.v) }; }
+	// a with its sign flipped where sign is negative
+	friend SimdFloat MulSign(SimdFloat a, SimdFloat sign) {
+		return { _mm256_xor_ps(a.v, _mm256_and_ps(sign.v, _mm256_set1_ps(-0.0f))) };
+	}
+#elif defined(SIMD_FLOAT_SSE)
+	static constexpr int kWidth = 4;
+	__m128 v;
+
+	static SimdFloat Load(const float* ptr)	{ return { _mm_load_ps(ptr) }; }
+	static SimdFloat Splat(float value)		{ return { _mm_set1_ps(value) }; }
+	void Store(float* ptr) const			{ _mm_store_ps(ptr, v); }
+
+	friend SimdFloat operator+(SimdFloat a, SimdFloat b) { return { _mm_add_ps(a.v, b.v) }; }
+	friend SimdFloat operator-(SimdFloat a, SimdFloat b) { return { _mm_sub_ps(a.v, b.v) }; }
+	friend SimdFloat operator*(SimdFloat a, SimdFloat b) { return { _mm_mul_ps(a.v, b.v) }; }
+	friend SimdFloat operator/(SimdFloat a, SimdFloat b) { return { _mm_div_ps(a.v, b.v) }; }
+	friend SimdFloat Sqrt(SimdFloat a)					 { return { _mm_sqrt_ps(a.v) }; }
+	friend SimdFloat MulSign(SimdFloat a, SimdFloat sign) {
+		return { _mm_xor_ps(a.v, _mm_and_ps(sign.v, _mm_set1_ps(-0.0f))) };
+	}
+#else
+	static constexpr int kWidth = 1;
+	float v;
+
+	static SimdFloat Load(const float* ptr)	{ return { *ptr }; }
+	static SimdFloat Splat(float value)		{ return { value }; }
+	void Store(float* ptr) const			{ *ptr = v; }
+
+	friend SimdFloat operator+(SimdFloat a, SimdFloat b) { return { a.v + b.v }; }
+	friend SimdFloat operator-(SimdFloat a, SimdFloat b) { return { a.v - b.v }; }
+	friend SimdFloat operator*(SimdFloat a, SimdFloat b) { return { a.v * b.v }; }
+	friend SimdFloat operator/(SimdFloat a, SimdFloat b) { return { a.v / b.v }; }
+	friend SimdFloat Sqrt(SimdFloat a)					 { return { std::sqrt(a.v) }; }
+	friend SimdFloat MulSign(SimdFloat a, SimdFloat sign) { return { std::signbit(sign.v) ? -a.v : a.v }; }
+#endif
+
+	static constexpr int kAlign = kWidth * sizeof(float) < 16 ? 16 : kWidth * sizeof(float);
+
+	// a + (b - a) * t
+	friend SimdFloat Lerp(SimdFloat a, SimdFloat b, SimdFloat t) { return a + (b - a) * t; }
+};
+
+#endif // !__SIMD_FLOAT_H
@@ -0,0 +1,143 @@
+#ifndef __TEXTURE_ARRAY_H
+#define __TEXTURE_ARRAY_H
+
+#include "gl_state.h"
+#include "logger.h"
+#include "texture_cache.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// generic vertex attribute carrying the array layers of a packed draw, ivec4(diffuse, specular, normal, height),
+// -1 where the mesh has no texture. Read as "layout(location = 7) in ivec4 material_layers" under TEXTURE_ARRAYS
+constexpr GLuint kMaterialLayerAttribute = 7;
+
+// where a 2D texture ended up after packing
+struct TextureLayer {
+	GLuint array = 0;	// GL_TEXTURE_2D_ARRAY, 0 when the texture was not packed
+	GLint  layer = -1;
+};
+
+// Copies 2D textures of the TextureCache into GL_TEXTURE_2D_ARRAY layers, one array per size class
+// (width, height, internal format), split when a class exceeds GL_MAX_ARRAY_TEXTURE_LAYERS.
+// Draws that sample through the arrays only differ in their layer indices, so meshes with different
+// textures of the same size can share one draw. The source textures are left alone, the cache and
+// other models still own them.
+class TextureArrays {
+public:
+	TextureArrays() = default;
+
+	TextureArrays(const TextureArrays&)			   = delete;
+	TextureArrays& operator=(const TextureArrays&) = delete;
+
+	// textures that are not uploaded (failed decode, placeholder) are skipped
+	void Pack(std::span<const unsigned int> textures) {
+		struct SizeClass {
+			TextureCache::Info		  info;
+			std::vector<unsigned int> textures;
+		};
+		std::vector<SizeClass> classes;
+		for (unsigned int id : textures) {
+			if (layers_.contains(id)) continue;
+			TextureCache::Info info = TextureCache::Describe(id);
+			if (info.width == 0) continue;
+			auto iter = std::find_if(classes.begin(), classes.end(), [&](const SizeClass& c) {
+				return c.info.width == info.width && c.info.height == info.height && c.info.internal_format == info.internal_format;
+			});
+			if (iter == classes.end()) iter = classes.insert(classes.end(), SizeClass{ info, {} });
+			if (std::find(iter->textures.begin(), iter->textures.end(), id) == iter->textures.end())
+				iter->textures.push_back(id);
+		}
+
+		GLint max_layers = 256;
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+		size_t packed = 0, first_array = arrays_.size();
+		for (const SizeClass& size_class : classes) {
+			for (size_t first = 0; first < size_class.textures.size(); first += max_layers) {
+				size_t count = std::min(size_class.textures.size() - first, static_cast<size_t>(max_layers));
+				Build(size_class.info, std::span(size_class.textures).subspan(first, count));
+				packed += count;
+			}
+		}
+		if (packed)
+			Logger::Message(std::format("packed {} textures into {} texture arrays, {:.2f} MB",
+				packed, arrays_.size() - first_array, bytes_ / (1024.0 * 1024.0)));
+	}
+
+	TextureLayer Find(unsigned int texture) const {
+		auto iter = layers_.find(texture);
+		return iter != layers_.end() ? iter->second : TextureLayer{};
+	}
+
+	void Release() {
+		for (GLuint array : arrays_) {
+			glDeleteTextures(1, &array);
+			GLState::ForgetTexture(array);
+		}
+		arrays_.clear();
+		layers_.clear();
+		bytes_ = 0;
+	}
+
+	inline bool	  Empty() const { return arrays_.empty(); }
+	inline size_t Count() const { return arrays_.size(); }
+	inline size_t Bytes() const { return bytes_; }
+
+private:
+	// one array holding textures, level 0 is copied on the GPU when GL 4.3 / ARB_copy_image allows it,
+	// otherwise read back and uploaded again. The mip chain is rebuilt for the whole array at the end
+	void Build(const TextureCache::Info& info, std::span<const unsigned int> textures) {
+		GLuint array = 0;
+		GLsizei layers = static_cast<GLsizei>(textures.size());
+		glGenTextures(1, &array);
+		GLState::BindTexture(0, GL_TEXTURE_2D_ARRAY, array);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, info.internal_format, info.width, info.height, layers, 0, info.format, GL_UNSIGNED_BYTE, nullptr);
+
+		bool copy_image = GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_copy_image;
+		size_t components = info.format == GL_RED ? 1 : info.format == GL_RGB ? 3 : 4;
+		std::vector<unsigned char> pixels;
+		if (!copy_image) {
+			pixels.resize(static_cast<size_t>(info.width) * info.height * components);
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		}
+		for (GLint layer = 0; layer < layers; ++layer) {
+			unsigned int texture = textures[layer];
+			if (copy_image) {
+				glCopyImageSubData(texture, GL_TEXTURE_2D, 0, 0, 0, 0, array, GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, info.width, info.height, 1);
+			}
+			else {
+				GLState::BindTexture(0, GL_TEXTURE_2D, texture);
+				glGetTexImage(GL_TEXTURE_2D, 0, info.format, GL_UNSIGNED_BYTE, pixels.data());
+				glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, info.width, info.height, 1, info.format, GL_UNSIGNED_BYTE, pixels.data());
+			}
+			layers_[texture] = { array, layer };
+		}
+		if (!copy_image) {
+			glPixelStorei(GL_PACK_ALIGNMENT, 4);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
+
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		arrays_.push_back(array);
+		bytes_ += static_cast<size_t>(info.width) * info.height * components * layers * 4 / 3;
+	}
+
+private:
+	std::vector<GLuint>							   arrays_;
+	std::unordered_map<unsigned int, TextureLayer> layers_;		// 2D texture -> array and layer
+	size_t										   bytes_ = 0;
+};
+
+#endif // !__TEXTURE_ARRAY_H
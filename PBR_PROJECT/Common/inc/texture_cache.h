@@ -0,0 +1,286 @@
+#ifndef __TEXTURE_CACHE_H
+#define __TEXTURE_CACHE_H
+
+#include "custom_macro.h"
+#include "gl_state.h"
+#include "hash_utils.h"
+#include "logger.h"
+#include "thread_pool.h"
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// decoded pixels of an image file, produced off the GL thread and consumed by UploadTextureImage
+struct TextureImage {
+	unsigned char* data		  = nullptr;
+	int			   width	  = 0;
+	int			   height	  = 0;
+	int			   components = 0;
+};
+
+// thread safe, touches no GL state
+inline TextureImage DecodeTextureImage(const std::string& filename)
+{
+	TextureImage image;
+	image.data = stbi_load(filename.c_str(), &image.width, &image.height, &image.components, 0);
+	return image;
+}
+
+// pixel format and internal format an image of that many components is uploaded with
+inline std::pair<GLenum, GLenum> TextureImageFormats(int components, bool gamma)
+{
+	GLenum format = GL_RGB;
+	if (components == 1)
+		format = GL_RED;
+	else if (components == 3)
+		format = GL_RGB;
+	else if (components == 4)
+		format = GL_RGBA;
+	GLenum internal_format = format;
+	if (gamma && format == GL_RGB)
+		internal_format = GL_SRGB;
+	else if (gamma && format == GL_RGBA)
+		internal_format = GL_SRGB_ALPHA;
+	return { format, internal_format };
+}
+
+// must run on the GL thread, frees the decoded pixels
+inline void UploadTextureImage(unsigned int texture_id, TextureImage& image, const char* path, bool gamma = false)
+{
+	if (image.data) {
+		auto [format, internal_format] = TextureImageFormats(image.components, gamma);
+
+		GLState::BindTexture(0, GL_TEXTURE_2D, texture_id);
+		glTexImage2D(GL_TEXTURE_2D, 0, internal_format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.data);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		stbi_image_free(image.data);
+		image.data = nullptr;
+	}
+	else {
+		Logger::Error(std::format("Texture failed to load at path: {}", path));
+	}
+}
+
+// Process wide, reference counted cache of 2D textures keyed by canonical path and gamma.
+// Only used from the GL thread, decoding of misses is fanned out to ThreadPool::Global().
+class TextureCache {
+
+	NoConstructor(TextureCache)
+
+	struct Key {
+		std::string path;
+		bool		gamma;
+		bool operator==(const Key& other) const { return gamma == other.gamma && path == other.path; }
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key& key) const { return static_cast<size_t>(HashValue(key.gamma, HashString(key.path))); }
+	};
+
+public:
+	// level 0 of an uploaded texture
+	struct Info {
+		int	   width		   = 0;
+		int	   height		   = 0;
+		GLenum format		   = 0;	// pixel transfer format, GL_RED / GL_RGB / GL_RGBA
+		GLenum internal_format = 0;
+	};
+
+private:
+	struct Entry {
+		unsigned int id		  = 0;
+		int			 refs	  = 0;
+		size_t		 bytes	  = 0;
+		bool		 uploaded = false;
+		Info		 info;
+	};
+
+	struct Pending {
+		unsigned int id;
+		std::string  path;
+		bool		 gamma;
+	};
+
+	struct InFlight {
+		Pending					  item;
+		std::future<TextureImage> decode;
+	};
+
+public:
+	// returns the texture for path, adding a reference. A miss reserves the texture name at once,
+	// its image is only decoded and uploaded by the next Flush()
+	static unsigned int Acquire(const std::string& path, bool gamma = false) {
+		Key key{ Canonical(path), gamma };
+		if (auto iter = entries_.find(key); iter != entries_.end()) {
+			++iter->second.refs;
+			return iter->second.id;
+		}
+
+		Entry entry;
+		glGenTextures(1, &entry.id);
+		entry.refs = 1;
+		auto [iter, _] = entries_.emplace(std::move(key), entry);
+		ids_[entry.id] = &iter->first;
+		pending_.push_back({ entry.id, iter->first.path, gamma });
+		return entry.id;
+	}
+
+	// convenience for callers that need the pixels right away
+	static unsigned int Load(const std::string& path, bool gamma = false) {
+		unsigned int id = Acquire(path, gamma);
+		Flush();
+		return id;
+	}
+
+	static void AddRef(unsigned int id) {
+		if (auto iter = ids_.find(id); iter != ids_.end()) {
+			++entries_[*iter->second].refs;
+		}
+	}
+
+	// drops a reference, the GL texture is deleted with the last one
+	static void Release(unsigned int id) {
+		auto id_iter = ids_.find(id);
+		if (id_iter == ids_.end()) return;
+		auto iter = entries_.find(*id_iter->second);
+		if (--iter->second.refs > 0) return;
+
+		std::erase_if(pending_, [id](const Pending& pending) { return pending.id == id; });
+		if (auto flight = std::find_if(in_flight_.begin(), in_flight_.end(), [id](const InFlight& f) { return f.item.id == id; });
+			flight != in_flight_.end()) {
+			stbi_image_free(flight->decode.get().data);
+			in_flight_.erase(flight);
+		}
+		glDeleteTextures(1, &iter->second.id);
+		GLState::ForgetTexture(iter->second.id);
+		ids_.erase(id_iter);
+		entries_.erase(iter);
+	}
+
+	// decodes every queued image on the worker pool at once and uploads each one as it completes,
+	// also waits for the decodes FlushAsync started
+	static void Flush() {
+		std::vector<InFlight> flights = StartDecodes();
+		for (InFlight& flight : in_flight_) flights.push_back(std::move(flight));
+		in_flight_.clear();
+		for (InFlight& flight : flights) {
+			TextureImage image = flight.decode.get();
+			Complete(flight.item, image);
+		}
+	}
+
+	// starts decoding every queued image without waiting, Poll() uploads them as they finish.
+	// Until then the textures hold a 1x1 grey placeholder so they can be sampled right away
+	static void FlushAsync() {
+		for (InFlight& flight : StartDecodes()) {
+			UploadPlaceholder(flight.item.id);
+			in_flight_.push_back(std::move(flight));
+		}
+	}
+
+	// uploads the decodes that finished since the last call, never blocks
+	static void Poll() {
+		for (size_t i = 0; i < in_flight_.size();) {
+			if (in_flight_[i].decode.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				++i;
+				continue;
+			}
+			TextureImage image = in_flight_[i].decode.get();
+			Complete(in_flight_[i].item, image);
+			if (i + 1 != in_flight_.size()) in_flight_[i] = std::move(in_flight_.back());
+			in_flight_.pop_back();
+		}
+	}
+
+	static bool IsIdle() { return pending_.empty() && in_flight_.empty(); }
+
+	// estimated GPU bytes of a texture including its mip chain, 0 until uploaded
+	static size_t Bytes(unsigned int id) {
+		auto iter = ids_.find(id);
+		return iter != ids_.end() ? entries_[*iter->second].bytes : 0;
+	}
+
+	static bool IsUploaded(unsigned int id) {
+		auto iter = ids_.find(id);
+		return iter != ids_.end() && entries_[*iter->second].uploaded;
+	}
+
+	// queued or decoding, the texture still holds nothing or the placeholder
+	static bool IsPending(unsigned int id) {
+		return std::any_of(pending_.begin(), pending_.end(), [id](const Pending& p) { return p.id == id; })
+			|| std::any_of(in_flight_.begin(), in_flight_.end(), [id](const InFlight& f) { return f.item.id == id; });
+	}
+
+	// size and format of an uploaded texture, all zero otherwise
+	static Info Describe(unsigned int id) {
+		auto iter = ids_.find(id);
+		return iter != ids_.end() && entries_[*iter->second].uploaded ? entries_[*iter->second].info : Info{};
+	}
+
+	static void Report() {
+		size_t bytes = 0;
+		for (const auto& [key, entry] : entries_) bytes += entry.bytes;
+		Logger::Message(std::format("texture cache - {} textures, {:.2f} MB", entries_.size(), bytes / (1024.0 * 1024.0)));
+	}
+
+private:
+	static std::vector<InFlight> StartDecodes() {
+		std::vector<InFlight> flights;
+		flights.reserve(pending_.size());
+		for (Pending& item : pending_) {
+			std::string path = item.path;
+			flights.push_back({ std::move(item), ThreadPool::Global().Submit([path] { return DecodeTextureImage(path); }) });
+		}
+		pending_.clear();
+		return flights;
+	}
+
+	static void Complete(const Pending& item, TextureImage& image) {
+		Entry& entry = entries_[Key{ item.path, item.gamma }];
+		// a mip chain adds about a third on top of the base level
+		entry.bytes	   = static_cast<size_t>(image.width) * image.height * image.components * 4 / 3;
+		entry.uploaded = image.data != nullptr;
+		if (entry.uploaded) {
+			auto [format, internal_format] = TextureImageFormats(image.components, item.gamma);
+			entry.info = { image.width, image.height, format, internal_format };
+		}
+		UploadTextureImage(item.id, image, item.path.c_str(), item.gamma);
+	}
+
+	static void UploadPlaceholder(unsigned int id) {
+		const unsigned char grey[4] = { 128, 128, 128, 255 };
+		GLState::BindTexture(0, GL_TEXTURE_2D, id);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	}
+
+	static std::string Canonical(const std::string& path) {
+		std::error_code ec;
+		std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+		return ec ? std::filesystem::path(path).lexically_normal().generic_string() : canonical.generic_string();
+	}
+
+private:
+	inline static std::unordered_map<Key, Entry, KeyHash>		entries_;
+	inline static std::unordered_map<unsigned int, const Key*>	ids_;
+	inline static std::vector<Pending>							pending_;
+	inline static std::vector<InFlight>							in_flight_;
+};
+
+#endif // !__TEXTURE_CACHE_H
@@ -0,0 +1,201 @@
+#ifndef __THREAD_POOL_H
+#define __THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed set of worker threads with a task deque each. A worker runs its own tasks newest first and,
+// once they are gone, takes the oldest task of the shared queue or steals the oldest one of another
+// worker. Tasks submitted from outside the pool go to the shared queue, which keeps them in order;
+// tasks submitted by a task stay with the worker that runs it.
+class ThreadPool {
+public:
+	explicit ThreadPool(size_t worker_count = DefaultWorkerCount()) {
+		queues_.reserve(worker_count);
+		for (size_t i = 0; i < worker_count; ++i) {
+			queues_.push_back(std::make_unique<Queue>());
+		}
+		workers_.reserve(worker_count);
+		for (size_t i = 0; i < worker_count; ++i) {
+			workers_.emplace_back([this, i] { WorkerLoop(i); });
+		}
+	}
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(sleep_mut_);
+			stop_ = true;
+		}
+		cond_.notify_all();
+		for (auto& worker : workers_) worker.join();
+	}
+
+	ThreadPool(const ThreadPool&)			 = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	template<class Func>
+	auto Submit(Func&& func) -> std::future<std::invoke_result_t<Func>> {
+		using Ret = std::invoke_result_t<Func>;
+		auto task = std::make_shared<std::packaged_task<Ret()>>(std::forward<Func>(func));
+		std::future<Ret> ret = task->get_future();
+		Push([task] { (*task)(); });
+		return ret;
+	}
+
+	// runs func(i) for i in [0, count) across the workers and the calling thread, returns when all are done.
+	// At most max_threads threads (the caller included) take part, 0 for all of them. Helpers that only get
+	// to run once every index is taken return at once, so the call never waits for busy workers to free up
+	template<class Func>
+	void ParallelFor(size_t count, Func&& func, size_t max_threads = 0) {
+		if (count == 0) return;
+		struct Range {
+			std::atomic<size_t> next = 0;
+			std::atomic<size_t> done = 0;
+		};
+		// helpers may start after the call returned, they only touch the range then
+		auto range = std::make_shared<Range>();
+		auto* body_func = &func;
+		auto body = [range, body_func, count] {
+			for (size_t i = range->next++; i < count; i = range->next++) {
+				(*body_func)(i);
+				++range->done;
+			}
+		};
+		size_t helper_count = std::min(workers_.size(), count - 1);
+		if (max_threads > 0) helper_count = std::min(helper_count, max_threads - 1);
+		for (size_t i = 0; i < helper_count; ++i) Push(body);
+		body();
+		while (range->done < count) {
+			if (!(ThisQueue() < queues_.size() && RunPendingTask())) std::this_thread::yield();
+		}
+	}
+
+	// waits for a std::future or std::shared_future; a worker runs queued tasks in the meantime, so
+	// waiting inside a task cannot starve the pool
+	template<class Future>
+	void Wait(const Future& future) {
+		if (ThisQueue() == queues_.size()) {
+			future.wait();
+			return;
+		}
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			if (!RunPendingTask()) std::this_thread::yield();
+		}
+	}
+
+	inline size_t WorkerCount() const { return workers_.size(); }
+
+	// the pool whose worker is calling, nullptr on threads outside every pool. Unlike Global it never
+	// constructs a pool, so it is safe during static destruction
+	static ThreadPool* Current() { return current_pool_; }
+
+	static ThreadPool& Global() {
+		static ThreadPool pool;
+		return pool;
+	}
+
+	static size_t DefaultWorkerCount() {
+		unsigned int hw = std::thread::hardware_concurrency();
+		return hw > 1 ? hw - 1 : 1;
+	}
+
+private:
+	using Task = std::function<void()>;
+
+	struct Queue {
+		std::mutex		 mut;
+		std::deque<Task> tasks;
+	};
+
+	// index of the calling thread's queue in this pool, queues_.size() for threads outside it
+	size_t ThisQueue() const {
+		return current_pool_ == this ? current_queue_ : queues_.size();
+	}
+
+	void Push(Task task) {
+		size_t index = ThisQueue();
+		Queue& queue = index < queues_.size() ? *queues_[index] : shared_;
+		{
+			// counted first so a Pop of the task can never take pending_ below zero, and under the lock
+			// so a worker between checking pending_ and going to sleep cannot miss the wakeup
+			std::lock_guard<std::mutex> lock(sleep_mut_);
+			++pending_;
+		}
+		{
+			std::lock_guard<std::mutex> lock(queue.mut);
+			queue.tasks.push_back(std::move(task));
+		}
+		cond_.notify_one();
+	}
+
+	// own queue newest first, then the shared queue, then the other workers oldest first
+	bool Pop(size_t index, Task& task) {
+		auto take = [&](Queue& queue, bool newest) {
+			std::lock_guard<std::mutex> lock(queue.mut);
+			if (queue.tasks.empty()) return false;
+			if (newest) {
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+			}
+			else {
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+			}
+			return true;
+		};
+		size_t count = queues_.size();
+		bool found = (index < count && take(*queues_[index], true)) || take(shared_, false);
+		for (size_t i = 1; !found && i <= count; ++i) {
+			size_t victim = (index + i) % count;
+			if (victim != index) found = take(*queues_[victim], false);
+		}
+		if (found) --pending_;
+		return found;
+	}
+
+	bool RunPendingTask() {
+		Task task;
+		if (!Pop(ThisQueue(), task)) return false;
+		task();
+		return true;
+	}
+
+	void WorkerLoop(size_t index) {
+		current_pool_  = this;
+		current_queue_ = index;
+		for (;;) {
+			Task task;
+			if (Pop(index, task)) {
+				task();
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleep_mut_);
+			cond_.wait(lock, [this] { return stop_ || pending_ > 0; });
+			if (stop_ && pending_ == 0) return;
+		}
+	}
+
+private:
+	std::vector<std::unique_ptr<Queue>> queues_;	// one per worker
+	Queue								shared_;	// submissions from outside the pool
+	std::vector<std::thread>			workers_;
+	std::atomic<size_t>					pending_ = 0;
+	std::mutex							sleep_mut_;
+	std::condition_variable				cond_;
+	bool								stop_ = false;
+
+	static inline thread_local ThreadPool* current_pool_  = nullptr;
+	static inline thread_local size_t	   current_queue_ = 0;
+};
+
+#endif // !__THREAD_POOL_H
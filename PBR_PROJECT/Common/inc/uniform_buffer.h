@@ -0,0 +1,92 @@
+#ifndef __UNIFORM_BUFFER_H
+#define __UNIFORM_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <utility>
+
+// Fixed binding points of the uniform blocks shared by the programs in Shaders/.
+// Every program that declares one of the blocks gets it bound at link time (see BindUniformBlocks),
+// so the buffers are attached once per context and written once per frame.
+enum UniformBlockBinding : GLuint {
+	kFrameBlockBinding = 0,		// FrameData
+	kLightBlockBinding = 1,		// LightData
+	kBonePaletteBinding = 2,	// BonePalette, or the BonePalettes storage block, see bone_palette.h
+};
+
+constexpr int kMaxPointLights = 4;
+constexpr int kMaxDirLights	  = 5;
+
+// std140 mirror of
+//	layout(std140) uniform FrameData { mat4 proj; mat4 view; vec4 camera_pos; vec4 time; };
+struct FrameUniforms {
+	glm::mat4 proj;
+	glm::mat4 view;
+	glm::vec4 camera_pos;		// w unused
+	glm::vec4 time;				// x seconds since start, y frame delta
+};
+static_assert(sizeof(FrameUniforms) == 160, "FrameUniforms must match the std140 FrameData block");
+
+// std140 mirror of the LightData block, arrays of vec4 so every element is 16 byte aligned
+struct LightUniforms {
+	glm::ivec4 light_counts{ 0 };					// x point lights, y directional lights
+	glm::vec4  point_light_pos[kMaxPointLights];	// world space, w unused
+	glm::vec4  point_light_color[kMaxPointLights];	// radiance, w unused
+	glm::vec4  dir_light_dir[kMaxDirLights];		// direction the light travels, w unused
+	glm::vec4  dir_light_color[kMaxDirLights];
+};
+static_assert(sizeof(LightUniforms) == 16 + 32 * kMaxPointLights + 32 * kMaxDirLights, "LightUniforms must match the std140 LightData block");
+
+inline constexpr std::pair<const char*, GLuint> kUniformBlocks[] = {
+	{ "FrameData", kFrameBlockBinding },
+	{ "LightData", kLightBlockBinding },
+	{ "BonePalette", kBonePaletteBinding },
+};
+
+// points the program's shared blocks at their fixed bindings, GLSL 330 has no binding layout qualifier
+inline void BindUniformBlocks(GLuint program)
+{
+	for (auto [name, binding] : kUniformBlocks) {
+		GLuint index = glGetUniformBlockIndex(program, name);
+		if (index != GL_INVALID_INDEX) glUniformBlockBinding(program, index, binding);
+	}
+}
+
+// one uniform buffer holding a T, attached to its binding point for the lifetime of the object.
+// Update replaces the whole block with a single glBufferSubData, call it once per frame before drawing
+template<class T>
+class UniformBuffer {
+public:
+	explicit UniformBuffer(GLuint binding) : binding_(binding) {
+		glGenBuffers(1, &buffer_);
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(T), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		Bind();
+	}
+
+	~UniformBuffer() {
+		glDeleteBuffers(1, &buffer_);
+	}
+
+	UniformBuffer(const UniformBuffer&)			   = delete;
+	UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+	void Update(const T& data) {
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer_);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(T), &data);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
+
+	// re-attaches the buffer, only needed if something else was bound to the same point
+	inline void	  Bind()	const { glBindBufferBase(GL_UNIFORM_BUFFER, binding_, buffer_); }
+	inline GLuint ID()		const { return buffer_; }
+	inline GLuint Binding() const { return binding_; }
+
+private:
+	GLuint binding_;
+	GLuint buffer_ = 0;
+};
+
+#endif // !__UNIFORM_BUFFER_H
@@ -0,0 +1,225 @@
+#ifndef __VERTEX_FORMAT_H
+#define __VERTEX_FORMAT_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#define MAX_BONE_INFLUENCE 4
+
+struct Vertex {
+    // position
+    glm::vec3 pos;
+    // normal
+    glm::vec3 norm;
+    // texCoords
+    glm::vec2 uv;
+    // tangent
+    glm::vec3 tang;
+    // bitangent
+    glm::vec3 bitang;
+    //bone indexes which will influence this vertex
+    int m_BoneIDs[MAX_BONE_INFLUENCE];
+    //weights from each bone
+    float m_Weights[MAX_BONE_INFLUENCE];
+};
+
+// GPU side vertex layouts, the CPU side always keeps the full Vertex
+enum class VertexFormat {
+    eFull,          // Vertex as is, 88 bytes
+    ePacked,        // PackedVertex, 32 bytes. Meshes without bones fall back to ePackedStatic
+    ePackedStatic   // PackedStaticVertex, 24 bytes, no skinning attributes
+};
+
+// normal and tangent are snorm 10:10:10:2, tangent.w holds the bitangent sign. There is no
+// bitangent attribute, vertex shaders rebuild it as cross(normal, tangent.xyz) * tangent.w
+struct PackedStaticVertex {
+    glm::vec3 pos;
+    uint32_t  norm;
+    uint32_t  tang;
+    uint32_t  uv;       // half2
+};
+
+struct PackedVertex {
+    glm::vec3 pos;
+    uint32_t  norm;
+    uint32_t  tang;
+    uint32_t  uv;       // half2
+    uint8_t   m_BoneIDs[MAX_BONE_INFLUENCE];
+    uint8_t   m_Weights[MAX_BONE_INFLUENCE];    // unorm8, summing to 255
+};
+
+static_assert(sizeof(PackedStaticVertex) == 24, "packed static vertex layout changed");
+static_assert(sizeof(PackedVertex) == 32, "packed vertex layout changed");
+
+inline PackedStaticVertex PackStaticVertex(const Vertex& vertex)
+{
+    auto safe_normalize = [](const glm::vec3& v, const glm::vec3& fallback) {
+        float len = glm::length(v);
+        return len > 1e-8f ? v / len : fallback;
+    };
+    glm::vec3 norm = safe_normalize(vertex.norm, glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::vec3 tang = safe_normalize(vertex.tang, glm::vec3(1.0f, 0.0f, 0.0f));
+    float     sign = glm::dot(glm::cross(norm, tang), vertex.bitang) < 0.0f ? -1.0f : 1.0f;
+
+    PackedStaticVertex packed;
+    packed.pos  = vertex.pos;
+    packed.norm = glm::packSnorm3x10_1x2(glm::vec4(norm, 0.0f));
+    packed.tang = glm::packSnorm3x10_1x2(glm::vec4(tang, sign));
+    packed.uv   = glm::packHalf2x16(vertex.uv);
+    return packed;
+}
+
+inline PackedVertex PackSkinnedVertex(const Vertex& vertex)
+{
+    PackedStaticVertex base = PackStaticVertex(vertex);
+    PackedVertex packed;
+    packed.pos  = base.pos;
+    packed.norm = base.norm;
+    packed.tang = base.tang;
+    packed.uv   = base.uv;
+
+    // unused slots become bone 0 with zero weight, the rounding error goes to the largest weight
+    int total = 0, largest = 0;
+    for (int i = 0; i < MAX_BONE_INFLUENCE; ++i) {
+        bool used = vertex.m_BoneIDs[i] >= 0;
+        packed.m_BoneIDs[i] = used ? static_cast<uint8_t>(vertex.m_BoneIDs[i]) : 0;
+        packed.m_Weights[i] = used ? static_cast<uint8_t>(std::clamp(vertex.m_Weights[i], 0.0f, 1.0f) * 255.0f + 0.5f) : 0;
+        total += packed.m_Weights[i];
+        if (packed.m_Weights[i] > packed.m_Weights[largest]) largest = i;
+    }
+    if (total > 0)
+        packed.m_Weights[largest] = static_cast<uint8_t>(std::clamp(packed.m_Weights[largest] + 255 - total, 0, 255));
+    return packed;
+}
+
+// ePacked degrades to ePackedStatic without bones and to eFull when ids do not fit a byte
+inline VertexFormat ResolveVertexFormat(VertexFormat format, std::span<const Vertex> vertices)
+{
+    if (format != VertexFormat::ePacked)
+        return format;
+    bool skinned = false;
+    for (const Vertex& vertex : vertices)
+    {
+        for (int i = 0; i < MAX_BONE_INFLUENCE; ++i)
+        {
+            if (vertex.m_BoneIDs[i] > UINT8_MAX)
+                return VertexFormat::eFull;
+            skinned |= vertex.m_BoneIDs[i] >= 0;
+        }
+    }
+    return skinned ? VertexFormat::ePacked : VertexFormat::ePackedStatic;
+}
+
+inline size_t VertexFormatStride(VertexFormat format)
+{
+    switch (format)
+    {
+    case VertexFormat::ePacked:       return sizeof(PackedVertex);
+    case VertexFormat::ePackedStatic: return sizeof(PackedStaticVertex);
+    default:                          return sizeof(Vertex);
+    }
+}
+
+// writes vertices in the given (resolved) layout to dst, which holds vertices.size() * VertexFormatStride(format) bytes.
+// dst is usually a mapped buffer range so the packed data is built in place
+inline void EncodeVertices(VertexFormat format, std::span<const Vertex> vertices, void* dst)
+{
+    switch (format)
+    {
+    case VertexFormat::eFull:
+        std::copy(vertices.begin(), vertices.end(), static_cast<Vertex*>(dst));
+        break;
+    case VertexFormat::ePacked:
+        std::transform(vertices.begin(), vertices.end(), static_cast<PackedVertex*>(dst), PackSkinnedVertex);
+        break;
+    case VertexFormat::ePackedStatic:
+        std::transform(vertices.begin(), vertices.end(), static_cast<PackedStaticVertex*>(dst), PackStaticVertex);
+        break;
+    }
+}
+
+// uploads vertices into [offset, offset + size) of the buffer bound to target, encoding straight into mapped memory
+inline void UploadVertices(GLenum target, GLintptr offset, VertexFormat format, std::span<const Vertex> vertices)
+{
+    GLsizeiptr size = static_cast<GLsizeiptr>(vertices.size() * VertexFormatStride(format));
+    if (size == 0)
+        return;
+    if (format == VertexFormat::eFull)
+    {
+        glBufferSubData(target, offset, size, vertices.data());
+        return;
+    }
+    void* dst = glMapBufferRange(target, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    if (dst)
+    {
+        EncodeVertices(format, vertices, dst);
+        // GL_FALSE means the store was lost while mapped (e.g. a display mode change) and its
+        // contents are undefined, so the range is written again below
+        if (glUnmapBuffer(target) == GL_TRUE)
+            return;
+    }
+    std::vector<std::byte> encoded(static_cast<size_t>(size));
+    EncodeVertices(format, vertices, encoded.data());
+    glBufferSubData(target, offset, size, encoded.data());
+}
+
+// configures the attribute pointers of the bound VAO for the buffer bound to GL_ARRAY_BUFFER
+inline void SetupVertexAttributes(VertexFormat format)
+{
+    if (format == VertexFormat::eFull)
+    {
+        // vertex Positions
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        // vertex normals
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, norm));
+        // vertex texture coords
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, uv));
+        // vertex tangent
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tang));
+        // vertex bitangent
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, bitang));
+        // ids
+        glEnableVertexAttribArray(5);
+        glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
+
+        // weights
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+    }
+    else
+    {
+        // both packed layouts share the leading attributes. Bitangent (location 4) is left disabled so
+        // it reads as zero, which tells skelanim.vert to rebuild it from the tangent sign
+        GLsizei stride = static_cast<GLsizei>(VertexFormatStride(format));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedStaticVertex, pos));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(PackedStaticVertex, norm));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedStaticVertex, uv));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(PackedStaticVertex, tang));
+        if (format == VertexFormat::ePacked)
+        {
+            glEnableVertexAttribArray(5);
+            glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, stride, (void*)offsetof(PackedVertex, m_BoneIDs));
+            glEnableVertexAttribArray(6);
+            glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(PackedVertex, m_Weights));
+        }
+    }
+}
+
+#endif // !__VERTEX_FORMAT_H
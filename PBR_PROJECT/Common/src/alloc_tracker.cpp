@@ -0,0 +1,55 @@
+#include "alloc_tracker.h"
+
+#include <cstdlib>
+#include <new>
+
+std::atomic<size_t> AllocTracker::count	  = 0;
+std::atomic<size_t> AllocTracker::bytes	  = 0;
+std::atomic<size_t> AllocTracker::current = 0;
+std::atomic<size_t> AllocTracker::peak	  = 0;
+
+#ifdef TRACK_ALLOCATIONS
+
+// every block carries its size in a header padded to the default new alignment
+namespace {
+	constexpr size_t kHeaderSize = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+	void* TrackedAlloc(size_t size) noexcept {
+		void* block = std::malloc(size + kHeaderSize);
+		if (!block) return nullptr;
+		*static_cast<size_t*>(block) = size;
+
+		AllocTracker::count.fetch_add(1, std::memory_order_relaxed);
+		AllocTracker::bytes.fetch_add(size, std::memory_order_relaxed);
+		size_t live = AllocTracker::current.fetch_add(size, std::memory_order_relaxed) + size;
+		size_t peak = AllocTracker::peak.load(std::memory_order_relaxed);
+		while (live > peak && !AllocTracker::peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+		return static_cast<char*>(block) + kHeaderSize;
+	}
+
+	void TrackedFree(void* ptr) noexcept {
+		if (!ptr) return;
+		void* block = static_cast<char*>(ptr) - kHeaderSize;
+		AllocTracker::current.fetch_sub(*static_cast<size_t*>(block), std::memory_order_relaxed);
+		std::free(block);
+	}
+}
+
+void* operator new(size_t size) {
+	if (void* ptr = TrackedAlloc(size)) return ptr;
+	throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return TrackedAlloc(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	TrackedFree(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	TrackedFree(ptr);
+}
+
+#endif // TRACK_ALLOCATIONS
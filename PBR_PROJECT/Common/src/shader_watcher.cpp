@@ -0,0 +1,102 @@
+#include "shader_watcher.h"
+
+#include <algorithm>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+ShaderWatcher::ShaderWatcher()
+{
+#ifdef __linux__
+	fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+	next_scan_ = std::chrono::steady_clock::now() + kScanInterval;
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+#ifdef __linux__
+	if (fd_ >= 0) close(fd_);
+#endif
+}
+
+std::filesystem::path ShaderWatcher::Normalize(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	std::filesystem::path normal = std::filesystem::weakly_canonical(path, ec);
+	return ec ? path.lexically_normal() : normal;
+}
+
+std::filesystem::path ShaderWatcher::Watch(const std::filesystem::path& file)
+{
+	std::filesystem::path path = Normalize(file);
+	auto iter = std::find_if(files_.begin(), files_.end(), [&](const File& f) { return f.path == path; });
+	if (iter != files_.end()) return path;
+	files_.push_back({ path, WriteTime(path) });
+
+#ifdef __linux__
+	std::filesystem::path dir = path.parent_path();
+	bool known = std::any_of(dirs_.begin(), dirs_.end(), [&](const auto& d) { return d.second == dir; });
+	if (fd_ >= 0 && !known) {
+		// editors that save through a temporary file end with a rename into place
+		int wd = inotify_add_watch(fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (wd >= 0) dirs_.emplace_back(wd, dir);
+	}
+#endif
+	return path;
+}
+
+std::vector<std::filesystem::path> ShaderWatcher::Poll()
+{
+	std::vector<std::filesystem::path> changed;
+	if (fd_ >= 0) {
+		PollNotifications(changed);
+	}
+	else if (std::chrono::steady_clock::now() >= next_scan_) {
+		Scan(changed);
+		next_scan_ = std::chrono::steady_clock::now() + kScanInterval;
+	}
+	return changed;
+}
+
+void ShaderWatcher::PollNotifications(std::vector<std::filesystem::path>& changed)
+{
+#ifdef __linux__
+	alignas(inotify_event) char buffer[4096];
+	for (;;) {
+		ssize_t size = read(fd_, buffer, sizeof(buffer));
+		if (size <= 0) break;
+		for (char* ptr = buffer; ptr < buffer + size; ptr += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(ptr)->len) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+			if (event->len == 0) continue;
+			auto dir = std::find_if(dirs_.begin(), dirs_.end(), [&](const auto& d) { return d.first == event->wd; });
+			if (dir == dirs_.end()) continue;
+			std::filesystem::path path = dir->second / event->name;
+			bool watched  = std::any_of(files_.begin(), files_.end(), [&](const File& f) { return f.path == path; });
+			bool reported = std::find(changed.begin(), changed.end(), path) != changed.end();
+			if (watched && !reported) changed.push_back(std::move(path));
+		}
+	}
+#endif
+}
+
+void ShaderWatcher::Scan(std::vector<std::filesystem::path>& changed)
+{
+	for (File& file : files_) {
+		std::filesystem::file_time_type time = WriteTime(file.path);
+		if (time != file.time) {
+			file.time = time;
+			changed.push_back(file.path);
+		}
+	}
+}
+
+std::filesystem::file_time_type ShaderWatcher::WriteTime(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	std::filesystem::file_time_type time = std::filesystem::last_write_time(path, ec);
+	return ec ? std::filesystem::file_time_type::min() : time;
+}
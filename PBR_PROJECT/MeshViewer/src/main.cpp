@@ -13,6 +13,9 @@
 #include "model.h"
 #include "mesh.h"
 #include "logger.h"
+#include "uniform_buffer.h"
+#include "shader_reloader.h"
+#include "gl_state.h"
 #define STB_IMAGE_IMPLEMENTATION
 
 #include <glm/gtx/transform.hpp>
@@ -39,6 +42,7 @@
 #define FRAG_PATH(name) SHADER_PATH_PREFIX#name".frag"
 
 void RenderScene();
+void UpdateUniformBuffers(float time, float delta_time);
 void RenderGUI	();
 
 void ProcessInput       (GLFWwindow* w, float delta_time);
@@ -138,10 +142,13 @@ int main() {
 		ProcessInput(window, delta_time);
 		glfwMakeContextCurrent(window);
 		
+		ShaderReloader::Update();
+		UpdateUniformBuffers(current_frame, delta_time);
 		RenderScene();
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		RenderGUI();
+		GLState::EndFrame();
 
 		if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
 			ImGui::UpdatePlatformWindows();
@@ -194,15 +201,34 @@ finish:
 	return h_pipe;
 }
 
+// camera and light state shared by both programs, written once per frame
+void UpdateUniformBuffers(float time, float delta_time) {
+	static UniformBuffer<FrameUniforms> frame_ubo(kFrameBlockBinding);
+	static UniformBuffer<LightUniforms> light_ubo(kLightBlockBinding);
+
+	frame_ubo.Update(FrameUniforms{
+		.proj		= glm::perspective(glm::radians(camera.Zoom), (float)render_width / std::max(render_height, 1u), 0.1f, 100.0f),
+		.view		= camera.GetViewMatrix(),
+		.camera_pos = glm::vec4(camera.pos, 1.0f),
+		.time		= glm::vec4(time, delta_time, 0.0f, 0.0f) });
+
+	LightUniforms lights{};
+	lights.light_counts		  = glm::ivec4(0, 1, 0, 0);
+	lights.dir_light_dir[0]	  = glm::vec4(glb_light.dir, 0.0f);
+	lights.dir_light_color[0] = glm::vec4(glb_light.color, 0.0f);
+	light_ubo.Update(lights);
+}
+
 void RenderScene(){
 	static Shader half_alpha_shader(VERT_PATH(simple_vert), FRAG_PATH(tile_color));
 	static Shader draw_line_shader (VERT_PATH(simple_vert), FRAG_PATH(draw_line));
+	static bool   shaders_watched = ShaderReloader::Watch(half_alpha_shader) && ShaderReloader::Watch(draw_line_shader);
 	static Mesh*  mesh = nullptr;
 	
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);	
+	GLState::BindFramebuffer(fbo);
 	glViewport(0, 0, render_width, render_height);
-	glEnable(GL_DEPTH_TEST);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLState::Enable(GL_DEPTH_TEST);
+	GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	if (!mesh) {
 		lock_guard<mutex> lock(mut);
@@ -213,17 +239,12 @@ void RenderScene(){
 	else {
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glm::mat4 proj = glm::perspective(glm::radians(camera.Zoom), (float)render_width / render_height, 0.1f, 100.0f);
-		glm::mat4 view = camera.GetViewMatrix();
 
 		//glEnable(GL_BLEND);
 		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 		half_alpha_shader.use();
 		// global settings
 		half_alpha_shader.setMat4("model", glm::mat4(1.0f));
-		half_alpha_shader.setMat4("view", view);
-		half_alpha_shader.setMat4("proj", proj);
-		half_alpha_shader.setVec3("camera_pos", camera.pos);
 		// material settings
 		half_alpha_shader.setInt  ("pri_tot_num", indices.size() / 3);
 		half_alpha_shader.setVec3 ("color_start", color_start);
@@ -231,40 +252,34 @@ void RenderScene(){
 		half_alpha_shader.setFloat("roughness",   roughness);
 		half_alpha_shader.setFloat("metalic",     metallic);
 		half_alpha_shader.setFloat("ao", 1.0f);
-		// light settings
-		half_alpha_shader.setInt ("direct_light_num", 1);
-		half_alpha_shader.setVec3("light_dir[0]",   glb_light.dir);
-		half_alpha_shader.setVec3("light_color[0]", glb_light.color);
 
-		glCullFace(GL_FRONT);
+		GLState::CullFace(GL_FRONT);
 		half_alpha_shader.setFloat("alpha", 0.3f);
 		mesh->Draw(half_alpha_shader);
 		
-		glCullFace(GL_BACK);
+		GLState::CullFace(GL_BACK);
 		half_alpha_shader.setFloat("alpha", 0.7f);		
 		mesh->Draw(half_alpha_shader);
 
-		glDisable(GL_BLEND);
+		GLState::Disable(GL_BLEND);
 		
 		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 		//glEnable(GL_LINE_STIPPLE);
 		draw_line_shader.use();
 		draw_line_shader.setMat4("model", glm::mat4(1.0f));
-		draw_line_shader.setMat4("view", view);
-		draw_line_shader.setMat4("proj", proj);
 		
 		glLineWidth(1.0f);
-		glDepthFunc(GL_GREATER);
+		GLState::DepthFunc(GL_GREATER);
 		draw_line_shader.setVec3("color", glm::vec3(0.55f));
 		mesh->Draw(draw_line_shader);
 
 		glLineWidth(2.0f);
-		glDepthFunc(GL_LESS);
+		GLState::DepthFunc(GL_LESS);
 		draw_line_shader.setVec3("color", glm::vec3(1.0f));
 		mesh->Draw(draw_line_shader);
-		glEnable(GL_DEPTH_TEST);
+		GLState::Enable(GL_DEPTH_TEST);
 	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::BindFramebuffer(0);
 }
 
 void RenderGUI() {
@@ -317,6 +332,8 @@ void RenderGUI() {
 		ImGui::ColorEdit3("color", glm::value_ptr(glb_light.color));
 	}
 	ImGui::Text("No Implementation");
+	const GLState::Counters& gl_calls = GLState::LastFrame();
+	ImGui::Text("GL state calls: %llu issued, %llu skipped", (unsigned long long)gl_calls.issued, (unsigned long long)gl_calls.skipped);
 	ImGui::End();
 
 	ImGui::Begin("Viewport");
@@ -502,6 +519,8 @@ void GenFrameBuffer(int width, int height) {
 	glBindTexture(GL_TEXTURE_2D, 0);
 
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+	// framebuffer and texture were bound behind the state cache
+	GLState::Invalidate();
 }
 
 void CleanFrameBuffer() {
@@ -509,6 +528,8 @@ void CleanFrameBuffer() {
 		glDeleteFramebuffers(1, &fbo);
 		glDeleteRenderbuffers(1, &rbo);
 		glDeleteTextures(1, &texture);
+		GLState::ForgetFramebuffer(fbo);
+		GLState::ForgetTexture(texture);
 	}
 }
 
@@ -8,8 +8,13 @@
 
 // common lib
 #include "shader.h"
+#include "shader_variants.h"
+#include "shader_reloader.h"
+#include "gl_state.h"
 #include "camera.h"
 #include "model.h"
+#include "texture_cache.h"
+#include "uniform_buffer.h"
 #define STB_IMAGE_IMPLEMENTATION
 
 #include <stb_image.h>
@@ -29,24 +34,21 @@ using namespace glm;
 #define VERT_PATH(name) SHADER_PATH_PREFIX#name".vert"
 #define FRAG_PATH(name) SHADER_PATH_PREFIX#name".frag"
 
-#ifdef PBR_TEXTURE
 #define RUSTED_IRON_DIR ASSET_PATH_DIR"/rusted_iron"
 #define VINTAGE_DIR     ASSET_PATH_DIR"/vintage"
-#endif // PBR_TEXTURE
 
 /*____________________________________const varaiable____________________________________*/
 
 
 /*____________________________________function declarations_______________________________*/
-#ifdef PBR_TEXTURE
 void		InitializeTexture();
-#endif // PBR_TEXTURE
 using tuuuu = tuple<uint32_t, uint32_t, uint32_t, uint32_t>;
 
-void        ModifyPBRShader();
+Shader&     PBRShader(bool textured, bool ibl);
 GLFWwindow* InitializeWindow();
 tuuuu		InitializeIBLResource(filesystem::path hdr_file);
 void		ProcessInput	(GLFWwindow* window, float delta_time);
+void		UpdateUniformBuffers(float time, float delta_time);
 void		RenderPass		();
 void		RenderSkyBox    (const uint32_t& cube_map);
 void	    RenderCube		(Shader& shader);
@@ -63,26 +65,33 @@ struct Light {
 Light m_light{ .pos = {10.0f, 0.0f, 10.0f},
 			   .color = {1.0f, 1.0f, 1.0f},
 			   .intensity = {300.0f} };
-// uniform sampler or variable var
+// material mode, both are shader permutations switchable at runtime, the build flags pick the initial one
 #ifdef PBR_TEXTURE
+bool textured_material	  = true;
+#else
+bool textured_material	  = false;
+#endif
+#ifdef IBL
+bool image_based_lighting = true;
+#else
+bool image_based_lighting = false;
+#endif
+// uniform sampler or variable var
 uint32_t albedo    = 0;
 uint32_t normal    = 0;
 uint32_t metallic  = 0;
 uint32_t roughness = 0;
 uint32_t ao		   = 0;
-#else
-float  metalic   = 0.05f;
-float  roughness = 0.05f;
-vec3   albedo    = vec3(0.5f, 0.0f, 0.0f);
-#endif
+
+float  metallic_value  = 0.05f;
+float  roughness_value = 0.05f;
+vec3   albedo_value    = vec3(0.5f, 0.0f, 0.0f);
 
 uint32_t cube_map     = 0;
 uint32_t hdr_texture  = 0;
-#ifdef IBL
 uint32_t irr_map      = 0;
 uint32_t pft_map      = 0;
 uint32_t brdf_lut_tex = 0;
-#endif
 
 int main()
 {	
@@ -91,14 +100,17 @@ int main()
 		glfwTerminate();
 		return 1;
 	};
-	glEnable(GL_DEPTH_TEST);
+	GLState::Enable(GL_DEPTH_TEST);
 	// set depth function to less than AND equal for skybox depth trick.
-	glDepthFunc(GL_LEQUAL);
+	GLState::DepthFunc(GL_LEQUAL);
 	// enable seamless cubemap sampling for lower mip levels in the pre-filter map.
 	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 	
-	ModifyPBRShader();
-	
+	// build every material permutation up front, switching modes later is a lookup
+	for (bool textured : { false, true })
+		for (bool ibl : { false, true })
+			PBRShader(textured, ibl);
+
 	tie(cube_map, irr_map, pft_map, brdf_lut_tex) = InitializeIBLResource(ASSET_PATH_DIR"/sunsetpeek/sunsetpeek_ref.hdr");
 
 	// the pos not good as far	
@@ -110,6 +122,9 @@ int main()
 		
 		ProcessInput(window, delta_time);
 
+		ShaderReloader::Update();
+		UpdateUniformBuffers(current_frame, delta_time);
+
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -118,6 +133,7 @@ int main()
 		RenderSkyBox(cube_map);
 
 		RenderGUI   ();
+		GLState::EndFrame();
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
@@ -127,18 +143,35 @@ int main()
 	return 0;
 }
 
+// camera and light state for every shader of the frame, written once before any pass
+void UpdateUniformBuffers(float time, float delta_time)
+{
+	static UniformBuffer<FrameUniforms> frame_ubo(kFrameBlockBinding);
+	static UniformBuffer<LightUniforms> light_ubo(kLightBlockBinding);
+
+	frame_ubo.Update(FrameUniforms{
+		.proj		= glm::perspective(glm::radians(camera.Zoom), (float)scr_width / std::max((float)scr_height, 1.0f), 0.1f, 100.0f),
+		.view		= camera.GetViewMatrix(),
+		.camera_pos = vec4(camera.pos, 1.0f),
+		.time		= vec4(time, delta_time, 0.0f, 0.0f) });
+
+	LightUniforms lights{};
+	lights.light_counts			= ivec4(1, 0, 0, 0);
+	lights.point_light_pos[0]	= vec4(m_light.pos, 1.0f);
+	lights.point_light_color[0] = vec4(m_light.intensity * m_light.color, 0.0f);
+	light_ubo.Update(lights);
+}
+
 void RenderSkyBox(const uint32_t& cube_map)
 {
 	static Shader skybox_shader(VERT_PATH(skybox), FRAG_PATH(skybox));
-	glDepthFunc(GL_LEQUAL);
+	static bool   skybox_watched = ShaderReloader::Watch(skybox_shader);
+	// LEQUAL is the depth function of the whole frame, the sphere does not need LESS
+	GLState::DepthFunc(GL_LEQUAL);
 	skybox_shader.use();
 	skybox_shader.setInt("env_map", 0);
-	skybox_shader.setMat4("proj", glm::perspective(glm::radians(camera.Zoom), (float)(scr_width) / (float)(scr_height), 0.1f, 100.0f));
-	skybox_shader.setMat4("view", camera.GetViewMatrix());
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cube_map);
+	GLState::BindTexture(0, GL_TEXTURE_CUBE_MAP, cube_map);
 	RenderCube(skybox_shader);
-	glDepthFunc(GL_LESS);
 }
 
 void	 RenderSphere(Shader & shader);
@@ -147,45 +180,38 @@ pair<uint32_t, uint32_t>
 uint32_t InitCubeResource();
 uint32_t InitQuadResource();
 
-void RenderPass()
+// pbr program for a material mode, all permutations share the sources read on first use
+Shader& PBRShader(bool textured, bool ibl)
 {
-	static Shader pbr_shader(VERT_PATH(pbr), FRAG_PATH(pbr));
-	
-	pbr_shader.use();
-#ifdef PBR_TEXTURE
-	static bool   shader_first_use = true;
-	if (shader_first_use) {
-		pbr_shader.setInt("albedo_map",	   0);
-		pbr_shader.setInt("normal_map",    1);
-		pbr_shader.setInt("metallic_map",  2);
-		pbr_shader.setInt("roughness_map", 3);
-		pbr_shader.setInt("ao_map",		   4);
-		shader_first_use = false;
+	// sampler units are fixed per program, set once when a permutation is built
+	static ShaderVariants pbr_variants(VERT_PATH(pbr), FRAG_PATH(pbr), nullptr, [](Shader& shader) {
+		shader.setInt("albedo_map",	   0);
+		shader.setInt("normal_map",    1);
+		shader.setInt("metallic_map",  2);
+		shader.setInt("roughness_map", 3);
+		shader.setInt("ao_map",		   4);
+		shader.setInt("irr_map",       5);
+		shader.setInt("pft_map",       6);
+		shader.setInt("brdf_lut_tex",  7);
+	});
+
+	std::string_view defines[2];
+	size_t count = 0;
+	if (textured) defines[count++] = "PBR_TEXTURE";
+	if (ibl)	  defines[count++] = "IBL";
+	return pbr_variants.Get(std::span<const std::string_view>(defines, count));
+}
 
+void RenderPass()
+{
+	if (textured_material && albedo == 0) {
 		InitializeTexture();
 	}
-#endif // PBR_TEXTURE
-#ifdef IBL
-	static bool    ibl_first_regiester = true;
-	if (ibl_first_regiester) {
-		pbr_shader.setInt("irr_map",      5);
-		pbr_shader.setInt("pft_map",      6);
-		pbr_shader.setInt("brdf_lut_tex", 7);
-		ibl_first_regiester = false;
 
-	}
-#endif // IBL
+	Shader& pbr_shader = PBRShader(textured_material, image_based_lighting);
+	pbr_shader.use();
 
-	
-	// set global vert properties
-	pbr_shader.setMat4("proj",  glm::perspective(glm::radians(camera.Zoom), (float)scr_width / scr_height, 0.1f, 100.0f));
-	pbr_shader.setMat4("view",  camera.GetViewMatrix());
-
-	// set global fragment properties
-	pbr_shader.setVec3("light_pos",	  m_light.pos);
-	pbr_shader.setVec3("light_color", m_light.intensity * m_light.color);
-	pbr_shader.setVec3("camera_pos",  camera.pos);
-	
+	// camera and lights come from the FrameData / LightData blocks
 	RenderSphere(pbr_shader);
 	
 }
@@ -203,34 +229,28 @@ void RenderSphere(Shader & shader)
 	shader.setMat4 ("model",     glm::mat4(1.0f));
 
 	// fragment attribution
-#ifdef PBR_TEXTURE
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, albedo);
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, normal);
-	glActiveTexture(GL_TEXTURE2);
-	glBindTexture(GL_TEXTURE_2D, metallic);
-	glActiveTexture(GL_TEXTURE3);
-	glBindTexture(GL_TEXTURE_2D, roughness);
-	glActiveTexture(GL_TEXTURE4);
-	glBindTexture(GL_TEXTURE_2D, ao);
-#else
-	shader.setVec3("albedo",	 albedo);
-	shader.setFloat("metallic",  metalic);
-	shader.setFloat("roughness", roughness);
-	shader.setFloat("ao",		 1.0f);
-#endif // PBR_TEXURE
+	// bindings survive from the last frame, only changed units reach GL
+	if (textured_material) {
+		GLState::BindTexture(0, GL_TEXTURE_2D, albedo);
+		GLState::BindTexture(1, GL_TEXTURE_2D, normal);
+		GLState::BindTexture(2, GL_TEXTURE_2D, metallic);
+		GLState::BindTexture(3, GL_TEXTURE_2D, roughness);
+		GLState::BindTexture(4, GL_TEXTURE_2D, ao);
+	}
+	else {
+		shader.setVec3("albedo",	 albedo_value);
+		shader.setFloat("metallic",  metallic_value);
+		shader.setFloat("roughness", roughness_value);
+		shader.setFloat("ao",		 1.0f);
+	}
 
-#ifdef IBL
-	glActiveTexture(GL_TEXTURE5);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, irr_map);
-	glActiveTexture(GL_TEXTURE6);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, pft_map);
-	glActiveTexture(GL_TEXTURE7);
-	glBindTexture(GL_TEXTURE_2D,	   brdf_lut_tex);
-#endif
+	if (image_based_lighting) {
+		GLState::BindTexture(5, GL_TEXTURE_CUBE_MAP, irr_map);
+		GLState::BindTexture(6, GL_TEXTURE_CUBE_MAP, pft_map);
+		GLState::BindTexture(7, GL_TEXTURE_2D,		 brdf_lut_tex);
+	}
 
-	glBindVertexArray(sphere_vao);
+	GLState::BindVertexArray(sphere_vao);
 	glDrawElements(GL_TRIANGLE_STRIP, index_count, GL_UNSIGNED_INT, 0);
 
 }
@@ -243,9 +263,8 @@ void RenderCube(Shader& shader)
 		cube_vao = InitCubeResource();
 	}
 
-	glBindVertexArray(cube_vao);
+	GLState::BindVertexArray(cube_vao);
 	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
 }
 
 void RenderQuad()
@@ -255,9 +274,8 @@ void RenderQuad()
 		vao = InitQuadResource();
 	}
 
-	glBindVertexArray(vao);
+	GLState::BindVertexArray(vao);
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glBindVertexArray(0);
 }
 
 void RenderGUI()
@@ -267,23 +285,36 @@ void RenderGUI()
 
 	ImGui::NewFrame();
 	ImGui::Begin("Setting Box");
+	ImGui::Text("GL state calls: %llu issued, %llu skipped", (unsigned long long)GLState::LastFrame().issued, (unsigned long long)GLState::LastFrame().skipped);
 	if(ImGui::CollapsingHeader("Light")){
 		ImGui::DragFloat3("pos",   glm::value_ptr(m_light.pos),   1.0f, -50.0f, 50.0f);
 		ImGui::ColorEdit3("color", glm::value_ptr(m_light.color));
 		ImGui::DragFloat("intensity", &m_light.intensity, 1.0f, 0.0f, 2000.0f);
 	}
 	ImGui::Separator();
-#ifdef PBR_TEXTURE
-	if (ImGui::CollapsingHeader("Textures")) {
+	if (ImGui::CollapsingHeader("Material")) {
+		// each combination is a prebuilt permutation of pbr.frag
+		ImGui::Checkbox("textured",			  &textured_material);
+		ImGui::Checkbox("image based lighting", &image_based_lighting);
+	}
+	if (!textured_material) {
+		ImGui::SliderFloat("metallic",  &metallic_value, 0.0f, 1.0f, "%.2f");
+		ImGui::SliderFloat("roughness", &roughness_value, 0.05f, 1.0f, "%.2f");
+		ImGui::ColorPicker3("albedo",   glm::value_ptr(albedo_value));
+	}
+	else if (ImGui::CollapsingHeader("Textures")) {
 		ImGui::Spacing(); ImGui::SameLine(15.0f);
 		if(ImGui::TreeNode("albedo")) {
 			ImGui::Spacing(); ImGui::SameLine(20.0f);
 			if (ImGui::ImageButton((GLuint*)albedo, ImVec2(75, 75))) {
 				std::filesystem::path albedo_path = GetPathFromOpenDialog();
 				if (!albedo_path.empty()) {
-					uint32_t new_albedo = TextureFromFile(albedo_path.filename().string().c_str(), albedo_path.parent_path().string());
-					if (0 != new_albedo) {
-						glDeleteTextures(1, &albedo); albedo = new_albedo;
+					uint32_t new_albedo = TextureCache::Load(albedo_path.generic_string());
+					if (TextureCache::IsUploaded(new_albedo)) {
+						TextureCache::Release(albedo); albedo = new_albedo;
+					}
+					else {
+						TextureCache::Release(new_albedo);
 					}
 				}
 			}
@@ -296,9 +327,12 @@ void RenderGUI()
 			if (ImGui::ImageButton((GLuint*)normal, ImVec2(75, 75))) {				
 				std::filesystem::path normal_path = GetPathFromOpenDialog();
 				if (!normal_path.empty()) {
-					uint32_t new_normal = TextureFromFile(normal_path.filename().string().c_str(), normal_path.parent_path().string());
-					if (0 != new_normal) {
-						glDeleteTextures(1, &normal); normal = new_normal;
+					uint32_t new_normal = TextureCache::Load(normal_path.generic_string());
+					if (TextureCache::IsUploaded(new_normal)) {
+						TextureCache::Release(normal); normal = new_normal;
+					}
+					else {
+						TextureCache::Release(new_normal);
 					}
 				}
 			}
@@ -310,9 +344,12 @@ void RenderGUI()
 			if (ImGui::ImageButton((GLuint*)metallic, ImVec2(75, 75))) {
 				std::filesystem::path metallic_path = GetPathFromOpenDialog();
 				if (!metallic_path.empty()) {
-					uint32_t new_metallic = TextureFromFile(metallic_path.filename().string().c_str(), metallic_path.parent_path().string());
-					if (0 != new_metallic) {
-						glDeleteTextures(1, &metallic); metallic = new_metallic;
+					uint32_t new_metallic = TextureCache::Load(metallic_path.generic_string());
+					if (TextureCache::IsUploaded(new_metallic)) {
+						TextureCache::Release(metallic); metallic = new_metallic;
+					}
+					else {
+						TextureCache::Release(new_metallic);
 					}
 				}
 			}
@@ -324,9 +361,12 @@ void RenderGUI()
 			if (ImGui::ImageButton((GLuint*)roughness, ImVec2(75, 75))) {
 				std::filesystem::path roughness_path = GetPathFromOpenDialog();
 				if (!roughness_path.empty()) {
-					uint32_t new_roughness = TextureFromFile(roughness_path.filename().string().c_str(), roughness_path.parent_path().string());
-					if (0 != new_roughness) {
-						glDeleteTextures(1, &roughness); roughness = new_roughness;
+					uint32_t new_roughness = TextureCache::Load(roughness_path.generic_string());
+					if (TextureCache::IsUploaded(new_roughness)) {
+						TextureCache::Release(roughness); roughness = new_roughness;
+					}
+					else {
+						TextureCache::Release(new_roughness);
 					}
 				}
 			}
@@ -338,20 +378,18 @@ void RenderGUI()
 			if (ImGui::ImageButton((GLuint*)ao, ImVec2(75, 75))) {
 				std::filesystem::path ao_path = GetPathFromOpenDialog();
 				if (!ao_path.empty()) {
-					uint32_t new_ao = TextureFromFile(ao_path.filename().string().c_str(), ao_path.parent_path().string());
-					if (0 != new_ao) {
-						glDeleteTextures(1, &ao); ao = new_ao;
+					uint32_t new_ao = TextureCache::Load(ao_path.generic_string());
+					if (TextureCache::IsUploaded(new_ao)) {
+						TextureCache::Release(ao); ao = new_ao;
+					}
+					else {
+						TextureCache::Release(new_ao);
 					}
 				}
 			}
 			ImGui::TreePop();
 		}
 	}
-#else
-	ImGui::SliderFloat("metalic",   &metalic, 0.0f, 1.0f, "%.2f");
-	ImGui::SliderFloat("roughness", &roughness, 0.05f, 1.0f, "%.2f");
-	ImGui::ColorPicker3("albedo",   glm::value_ptr(albedo));		
-#endif // PBR_TEXTURE
 
 	if (ImGui::CollapsingHeader("Background")) {
 		ImGui::Text("HDR");
@@ -362,9 +400,9 @@ void RenderGUI()
 				(hdr_path.filename().string().rfind("hdr") != string::npos || hdr_path.filename().string().rfind("exr") != string::npos)) {
 				auto [env, irr, pft, brdf_lut] = InitializeIBLResource(hdr_path);
 				if (env != 0) {
-					glDeleteTextures(1, &cube_map); cube_map = env;
-					glDeleteTextures(1, &irr_map);	irr_map = irr;
-					glDeleteTextures(1, &pft_map);  pft_map = pft;
+					glDeleteTextures(1, &cube_map); GLState::ForgetTexture(cube_map); cube_map = env;
+					glDeleteTextures(1, &irr_map);	GLState::ForgetTexture(irr_map);  irr_map = irr;
+					glDeleteTextures(1, &pft_map);  GLState::ForgetTexture(pft_map);  pft_map = pft;
 				}
 			}
 		}
@@ -441,7 +479,7 @@ pair<uint32_t, uint32_t> InitSphereResource()
 	uint32_t vao;
 
 	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+	GLState::BindVertexArray(vao);
 	glBindBuffer(GL_ARRAY_BUFFER, bo[0]);
 	glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0], GL_STATIC_DRAW);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bo[1]);
@@ -511,7 +549,7 @@ uint32_t InitCubeResource()
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-	glBindVertexArray(vao);
+	GLState::BindVertexArray(vao);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(1);
@@ -519,7 +557,7 @@ uint32_t InitCubeResource()
 	glEnableVertexAttribArray(2);
 	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));	
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
 
 	return vao;
 }
@@ -537,7 +575,7 @@ uint32_t InitQuadResource()
 	glGenVertexArrays(1, &vao);
 	glGenBuffers(1, &vbo);
 	
-	glBindVertexArray(vao);
+	GLState::BindVertexArray(vao);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 	glEnableVertexAttribArray(0);
@@ -598,41 +636,15 @@ void ProcessInput(GLFWwindow* window, float delta_time)
 	
 }
 
-#ifdef PBR_TEXTURE
 void InitializeTexture()
 {
 	stbi_set_flip_vertically_on_load(false);
-	albedo    = TextureFromFile("albedo.png",    RUSTED_IRON_DIR);
-	normal    = TextureFromFile("normal.png",    RUSTED_IRON_DIR);
-	metallic  = TextureFromFile("metallic.png",  RUSTED_IRON_DIR);
-	roughness = TextureFromFile("roughness.png", RUSTED_IRON_DIR);
-	ao		  = TextureFromFile("ao.png",		 RUSTED_IRON_DIR);
-}
-#endif // PBR_TEXTURE
-
-void ModifyPBRShader()
-{
-	fstream f;
-	f.open(FRAG_PATH(pbr), ios::in | ios::binary | ios::out);
-	if (f.is_open()) {
-		f.seekp(20, ios_base::beg);
-#ifdef PBR_TEXTURE
-		f << "#define PBR_TEXTURE\n";
-#else
-		f << "                   \n";
-#endif
-
-#ifdef IBL
-		f << "#define IBL";
-#else
-		f << "           ";
-#endif
-	}
-	else {
-		cout << "File open failure, some error occur\n";
-	}
-
-	f.close();
+	albedo    = TextureCache::Acquire(RUSTED_IRON_DIR"/albedo.png");
+	normal    = TextureCache::Acquire(RUSTED_IRON_DIR"/normal.png");
+	metallic  = TextureCache::Acquire(RUSTED_IRON_DIR"/metallic.png");
+	roughness = TextureCache::Acquire(RUSTED_IRON_DIR"/roughness.png");
+	ao		  = TextureCache::Acquire(RUSTED_IRON_DIR"/ao.png");
+	TextureCache::Flush();
 }
 
 GLFWwindow* InitializeWindow()
@@ -697,6 +709,7 @@ InitializeIBLResource(filesystem::path hdr_path)
 		// using a class and RAII to hold the Resource
 		if (hdr_texture != 0) {
 			glDeleteTextures(1, &hdr_texture);
+			GLState::ForgetTexture(hdr_texture);
 			hdr_texture = 0;
 		}
 		glGenTextures(1, &hdr_texture);
@@ -873,6 +886,8 @@ InitializeIBLResource(filesystem::path hdr_path)
 	glDeleteRenderbuffers(1,  &rbo);
 	glDepthFunc(GL_LESS);
 	glViewport(0, 0, scr_width, scr_height);
+	// the capture passes bound framebuffers and textures behind the state cache
+	GLState::Invalidate();
 
 	return { env_cubemap, irr_cubemap, prefilter_map, brdf_texture};
 }
@@ -9,6 +9,18 @@ uniform sampler2D texture_specular1;
 uniform sampler2D texture_emission1;
 uniform sampler2D texture_normal1;
 
+#ifdef TEXTURE_ARRAYS
+// packed materials, see TextureArrays. layers is -1 for draws that use the 2D textures above
+uniform sampler2DArray texture_diffuse_array;
+flat in ivec4 layers;
+#endif
+
 void main(){
+#ifdef TEXTURE_ARRAYS
+	if (layers.x >= 0) {
+		frag_color = texture(texture_diffuse_array, vec3(texcoords, layers.x));
+		return;
+	}
+#endif
 	frag_color = texture(texture_diffuse1, texcoords);
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 #version 330 core
 
-#define PBR_TEXTURE
-#define IBL
+// PBR_TEXTURE and IBL are injected per permutation, see ShaderVariants
 
 out vec4 frag_color;
 
@@ -23,12 +22,24 @@ uniform float metallic;
 uniform float roughness;
 uniform float ao;
 #endif
-// lights 
-uniform vec3 light_pos;
-uniform vec3 light_color;
-
-// camera
-uniform vec3 camera_pos;
+// per frame data, kFrameBlockBinding in uniform_buffer.h
+layout(std140) uniform FrameData {
+	mat4 proj;
+	mat4 view;
+	vec4 camera_pos;
+	vec4 time;
+};
+
+// scene lights, kLightBlockBinding in uniform_buffer.h
+#define MAX_POINT_LIGHTS 4
+#define MAX_DIR_LIGHTS   5
+layout(std140) uniform LightData {
+	ivec4 light_counts;				// x point lights, y directional lights
+	vec4  point_light_pos[MAX_POINT_LIGHTS];
+	vec4  point_light_color[MAX_POINT_LIGHTS];
+	vec4  dir_light_dir[MAX_DIR_LIGHTS];
+	vec4  dir_light_color[MAX_DIR_LIGHTS];
+};
 
 #ifdef IBL
 uniform samplerCube irr_map;
@@ -106,7 +117,7 @@ void main()
 #else
 	vec3  N  = normalize(normal);							// normal vector
 #endif	
-	vec3  V  = normalize(camera_pos - world_pos);			// lookat vector
+	vec3  V  = normalize(camera_pos.xyz - world_pos);			// lookat vector
 
 #ifdef IBL
 	vec3  R	 = reflect(-V, N);	
@@ -116,13 +127,14 @@ void main()
 	F0 = mix(F0, albedo, metallic);
 
 	vec3  Lo = vec3(0.0);									// output radiance	
-	{
+	for(int i = 0; i < light_counts.x; ++i){
 	// caculate the irrandiance
+	vec3  light_pos = point_light_pos[i].xyz;
 	vec3  L = normalize(light_pos - world_pos);				// incident vector
 	vec3  H = normalize(V + L);								// halfway vector
 	float light_distance = length(light_pos - world_pos);
 	float attenuation    = 1.0 / (light_distance * light_distance);
-	vec3  radiance		 = light_color * attenuation;
+	vec3  radiance		 = point_light_color[i].rgb * attenuation;
 
 	
 	vec3 Fres = FresnelSchlick(max(dot(H, V), 0.0), F0, roughness);
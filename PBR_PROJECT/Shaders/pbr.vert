@@ -8,8 +8,14 @@ out vec2 tex_coords;
 out vec3 world_pos;
 out vec3 normal;
 
-uniform mat4 proj;
-uniform mat4 view;
+// per frame data, kFrameBlockBinding in uniform_buffer.h
+layout(std140) uniform FrameData {
+	mat4 proj;
+	mat4 view;
+	vec4 camera_pos;
+	vec4 time;
+};
+
 uniform mat4 model;
 
 void main(){
@@ -6,8 +6,14 @@ layout(location = 1) in vec3 anorm;
 layout(location = 0) out vec3 world_pos;
 layout(location = 1) out vec3 normal;
 
-uniform mat4 proj;
-uniform mat4 view;
+// per frame data, kFrameBlockBinding in uniform_buffer.h
+layout(std140) uniform FrameData {
+	mat4 proj;
+	mat4 view;
+	vec4 camera_pos;
+	vec4 time;
+};
+
 uniform mat4 model;
 
 void main(){
@@ -3,36 +3,79 @@
 layout(location = 0) in vec3  pos;
 layout(location = 1) in vec3  norm;
 layout(location = 2) in vec2  tex;
+// packed layouts store the bitangent sign in tangent.w and leave location 4 disabled (zero)
+layout(location = 3) in vec4  tangent;
+layout(location = 4) in vec3  bitangent;
 layout(location = 5) in ivec4 bone_ids; 
 layout(location = 6) in vec4  weights;
+#ifdef TEXTURE_ARRAYS
+// kMaterialLayerAttribute, per draw array layers of a packed material
+layout(location = 7) in ivec4 material_layers;
+flat out ivec4 layers;
+#endif
+
+// per frame data, kFrameBlockBinding in uniform_buffer.h
+layout(std140) uniform FrameData {
+	mat4 proj;
+	mat4 view;
+	vec4 camera_pos;
+	vec4 time;
+};
 
-uniform mat4 proj;
-uniform mat4 view;
 uniform mat4 model;
 
 const int kMaxBones = 100;
 const int kMaxBoneInfluence = 4;
 
-uniform mat4 bone_matrices_arr[kMaxBones];
+// bone palettes, kBonePaletteBinding in uniform_buffer.h, written by BonePaletteBuffer
+#ifdef BONE_PALETTE_STORAGE
+// every character of the frame, this draw's palette starts at palette_offset
+layout(std430, binding = 2) readonly buffer BonePalettes {
+	mat4 bone_palettes[];
+};
+uniform int palette_offset;
+#define BONE_MATRIX(i) bone_palettes[palette_offset + (i)]
+#else
+// this draw's character, bound as a range of the buffer
+layout(std140) uniform BonePalette {
+	mat4 bone_matrices_arr[kMaxBones];
+};
+#define BONE_MATRIX(i) bone_matrices_arr[i]
+#endif
 
 out vec2 texcoords;
+// world space tangent frame for normal mapping
+out mat3 tbn;
 
 void main(){
-	vec4 pos_sum = vec4(0.0f);
+	vec3 bitang = dot(bitangent, bitangent) > 0.0f ? bitangent : cross(norm, tangent.xyz) * tangent.w;
+
+	vec4 pos_sum	= vec4(0.0f);
+	vec3 norm_sum	= vec3(0.0f);
+	vec3 tang_sum	= vec3(0.0f);
+	vec3 bitang_sum = vec3(0.0f);
 	for(uint i = 0; i < kMaxBoneInfluence; i++){
 		if(bone_ids[i] == -1) 
 			continue;
 		if(bone_ids[i] >= kMaxBones){
-			pos_sum = vec4(pos, 1.0f);
+			pos_sum	   = vec4(pos, 1.0f);
+			norm_sum   = norm;
+			tang_sum   = tangent.xyz;
+			bitang_sum = bitang;
 			break;
 		}
-		vec4 local_pos  = bone_matrices_arr[bone_ids[i]] * vec4(pos, 1.0f);
-		pos_sum += local_pos * weights[i];
-		// the step use for ?
-		vec3 local_norm = mat3(bone_matrices_arr[bone_ids[i]]) * norm;
+		mat4 bone = BONE_MATRIX(bone_ids[i]);
+		pos_sum	   += bone * vec4(pos, 1.0f) * weights[i];
+		norm_sum   += mat3(bone) * norm * weights[i];
+		tang_sum   += mat3(bone) * tangent.xyz * weights[i];
+		bitang_sum += mat3(bone) * bitang * weights[i];
 	}
 
 	gl_Position = proj * view * model * pos_sum;
 	texcoords   = tex;
+	tbn			= mat3(model) * mat3(normalize(tang_sum), normalize(bitang_sum), normalize(norm_sum));
+#ifdef TEXTURE_ARRAYS
+	layers      = material_layers;
+#endif
 	
 }
\ No newline at end of file
@@ -2,8 +2,13 @@
 
 layout(location = 0) in vec3 apos;
 
-uniform mat4 proj;
-uniform mat4 view;
+// per frame data, kFrameBlockBinding in uniform_buffer.h
+layout(std140) uniform FrameData {
+	mat4 proj;
+	mat4 view;
+	vec4 camera_pos;
+	vec4 time;
+};
 
 out vec3 local_pos;
 
@@ -17,13 +17,25 @@ uniform float roughness;
 uniform float ao;
 
 //__________________ Light Properties ____________________________________
-#define MAX_DIR_LIGHT_NB 5
-uniform int   direct_light_num;
-uniform vec3  light_dir[5];
-uniform vec3  light_color[5];
+// scene lights, kLightBlockBinding in uniform_buffer.h
+#define MAX_POINT_LIGHTS 4
+#define MAX_DIR_LIGHTS   5
+layout(std140) uniform LightData {
+	ivec4 light_counts;				// x point lights, y directional lights
+	vec4  point_light_pos[MAX_POINT_LIGHTS];
+	vec4  point_light_color[MAX_POINT_LIGHTS];
+	vec4  dir_light_dir[MAX_DIR_LIGHTS];
+	vec4  dir_light_color[MAX_DIR_LIGHTS];
+};
 
 //__________________ Camera Properties ___________________________________
-uniform vec3  camera_pos;
+// per frame data, kFrameBlockBinding in uniform_buffer.h
+layout(std140) uniform FrameData {
+	mat4 proj;
+	mat4 view;
+	vec4 camera_pos;
+	vec4 time;
+};
 
 const float   Pi = 3.1415295359;
 
@@ -64,15 +76,15 @@ float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness){
 
 void main(){	
 	vec3 N = normalize(norm);					// normal
-	vec3 V = normalize(camera_pos - world_pos); // view direction
+	vec3 V = normalize(camera_pos.xyz - world_pos); // view direction
 	vec3 albedo =  mix(color_start, color_end, gl_PrimitiveID / float(pri_tot_num)).xyz; 
 		
 	// caculate Fresnel term
 	vec3  F0 = mix(vec3(0.04), albedo, metallic);
 	vec3  Lo = vec3(0.0);
 	
-	for(int i = 0; i < direct_light_num; ++i){
-		vec3 L = normalize(-light_dir[i]);
+	for(int i = 0; i < light_counts.y; ++i){
+		vec3 L = normalize(-dir_light_dir[i].xyz);
 		vec3 H = normalize(V + L);					// half vector direction
 		vec3  Fres = FresnelSchlick(max(dot(H, V), 0.0), F0, roughness);
 
@@ -89,7 +101,7 @@ void main(){
 
 		float NdotL = max(dot(N, L), 0.0);
 		
-		Lo += (Kd * albedo / Pi + specular) * light_color[i] * NdotL;
+		Lo += (Kd * albedo / Pi + specular) * dir_light_color[i].rgb * NdotL;
 	}
 
 	vec3  F = FresnelSchlick(max(dot(N, V), 0.0), F0, roughness);
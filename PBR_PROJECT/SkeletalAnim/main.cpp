@@ -11,24 +11,48 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
+#include <chrono>
+#include <future>
 #include <iostream>
+#include <memory>
+#include "animation_crowd.h"
 #include "animator.h"
 #include "animation.h"
+#include "bone_palette.h"
+#include "thread_pool.h"
+#include "uniform_buffer.h"
+#include "shader_reloader.h"
+#include "gl_state.h"
 
 
 #define VERT_PATH(name) SHADER_PATH_PREFIX#name".vert"
 #define FRAG_PATH(name) SHADER_PATH_PREFIX#name".frag"
+#define VAMPIRE_PATH MODEL_PATH_DIR"/vampire/dancing_vampire.dae"
 
 using namespace glm;
 GLFWCustomWindow window("orge dancing", scr_width, scr_height);
 Camera			 camera(vec3(0.0f, 0.0f, 5.0f));
-Model			 model(MODEL_PATH_DIR"/vampire/dancing_vampire.dae");
-Animation		 anim(MODEL_PATH_DIR"/vampire/dancing_vampire.dae", &model);
-Animator		 animator(&anim);
+// both load in the background, the first frames draw whatever has arrived in bind pose
+std::unique_ptr<Model>					model;
+std::unique_ptr<Animation>				anim;
+std::future<std::unique_ptr<Animation>> anim_loading;
+Animator		 animator(nullptr);
 bool			 g_cursor_entered = false;
 float			 g_anim_speed = 1.0f;
+float			 g_upload_ms = 0.0f;		// smoothed CPU time of the bone palette upload
+float			 g_pose_ms = 0.0f;			// smoothed CPU time of the animator update
+bool			 g_simd_pose = true;		// off: scalar per bone sampling, for comparison
+AnimationCrowd	 crowd;						// extra characters, drawn behind the dancer on request
+int				 g_crowd_size = 0;
+int				 g_crowd_threads = 0;		// 0: the whole pool
+float			 g_crowd_ms = 0.0f;			// smoothed CPU time of the crowd update
+bool			 g_draw_crowd = false;		// off: the crowd is only updated
+bool			 g_cpu_skinning = false;	// skin the dancer on the CPU as well, to measure it
+float			 g_skin_ms = 0.0f;			// smoothed CPU time of the CPU skinning
+size_t			 g_skinned_vertices = 0;
 void InitWindowSetting();
 void InitGUI();
+void LoadAssets();
 void main_loop();
 void ProcessInput(GLFWwindow* window, float delta_time);
 
@@ -36,13 +60,21 @@ int APIENTRY WinMain(HINSTANCE hInst, HINSTANCE hInstPrev, PSTR cmdline, int cmd
 	
 	InitGUI();
 	InitWindowSetting();
+	LoadAssets();
 	
 	window.m_loop_func = main_loop;	
 
 	window.Run();
 
+	// released while the GL context and the thread pool are still alive: namespace-scope objects are
+	// destroyed after the pool, a function-local static first used later
+	if (anim_loading.valid()) anim_loading.wait();
+	anim.reset();
+	model.reset();
+	return 0;
 }
 
+void UpdateUniformBuffers(float time, float delta_time);
 void RenderScene();
 void RenderGUI();
 
@@ -54,39 +86,129 @@ void main_loop() {
 	last_frame = current_frame;
 
 	ProcessInput(window.m_window_ptr, delta_time);
+	if (anim_loading.valid() && anim_loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		anim = anim_loading.get();
+		animator.PlayAnimation(anim.get());
+	}
+	auto pose_start = std::chrono::steady_clock::now();
+	animator.SetSimdSampling(g_simd_pose);
 	animator.UpdateAnimation(g_anim_speed * delta_time);
+	float pose_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - pose_start).count();
+	g_pose_ms = g_pose_ms * 0.95f + pose_ms * 0.05f;
+
+	if (anim && crowd.Size() != static_cast<size_t>(g_crowd_size)) {
+		crowd.Clear();
+		for (int i = 0; i < g_crowd_size; ++i) {
+			// spread over the clip so the characters do not move in lockstep
+			crowd.Add(anim.get(), anim->GetDuration() * i / std::max(g_crowd_size, 1), 0.8f + 0.4f * (i % 5) / 4.0f);
+		}
+	}
+	if (g_cpu_skinning) {
+		// model space positions and normals of the current pose, nothing reads them yet
+		static std::vector<glm::vec3> skinned_pos, skinned_norm;
+		auto skin_start = std::chrono::steady_clock::now();
+		g_skinned_vertices = 0;
+		for (const Mesh& mesh : model->meshes) {
+			skinned_pos.resize(mesh.skinning.size());
+			skinned_norm.resize(mesh.skinning.size());
+			CpuSkinning::Skin(mesh.skinning, animator.GetBoneMatrices(), skinned_pos, skinned_norm);
+			g_skinned_vertices += mesh.skinning.size();
+		}
+		float skin_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - skin_start).count();
+		g_skin_ms = g_skin_ms * 0.95f + skin_ms * 0.05f;
+	}
+
+	auto crowd_start = std::chrono::steady_clock::now();
+	crowd.Update(g_anim_speed * delta_time, static_cast<size_t>(g_crowd_threads));
+	float crowd_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - crowd_start).count();
+	g_crowd_ms = g_crowd_ms * 0.95f + crowd_ms * 0.05f;
 
+	ShaderReloader::Update();
+	UpdateUniformBuffers(current_frame, delta_time);
 	RenderScene();
 
 	RenderGUI();
+	GLState::EndFrame();
+}
+
+// camera state for the frame, written once before any draw
+void UpdateUniformBuffers(float time, float delta_time)
+{
+	static UniformBuffer<FrameUniforms> frame_ubo(kFrameBlockBinding);
+	frame_ubo.Update(FrameUniforms{
+		.proj		= glm::perspective(glm::radians(camera.Zoom), (float)scr_width / std::max((float)scr_height, 1.0f), 0.1f, 100.0f),
+		.view		= camera.GetViewMatrix(),
+		.camera_pos = glm::vec4(camera.pos, 1.0f),
+		.time		= glm::vec4(time, delta_time, 0.0f, 0.0f) });
 }
 
 void RenderScene()
 {
-	static Shader anim_shader(VERT_PATH(skelanim), FRAG_PATH(mesh_render));
-	glEnable(GL_DEPTH_TEST);
+	// the model packs its textures into arrays, see ModelLoadOptions::texture_arrays;
+	// palettes come from a storage buffer where the context has them, else from a uniform block
+	static const std::vector<std::string_view> anim_defines = BonePaletteBuffer::StorageSupported()
+		? std::vector<std::string_view>{ "TEXTURE_ARRAYS", BonePaletteBuffer::Define() }
+		: std::vector<std::string_view>{ "TEXTURE_ARRAYS" };
+	static Shader anim_shader(VERT_PATH(skelanim), FRAG_PATH(mesh_render), nullptr, anim_defines);
+	static BonePaletteBuffer palette_buffer;
+	GLState::Enable(GL_DEPTH_TEST);
 	glClearColor(0.0, 0.0f, 0.0f, 0.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	anim_shader.use();
+	static Uniform<glm::mat4> model_uniform	 = anim_shader.getUniform<glm::mat4>("model");
+	static Uniform<int>		  offset_uniform = anim_shader.getUniform<int>("palette_offset");
+	// locations may move when the program is relinked, resolve the handles again
+	static bool watched = ShaderReloader::Watch(anim_shader, [](Shader& shader) {
+		model_uniform  = shader.getUniform<glm::mat4>("model");
+		offset_uniform = shader.getUniform<int>("palette_offset");
+	});
 
-	glm::mat4 proj = glm::perspective(glm::radians(camera.Zoom), (float)scr_width / std::max((float)scr_height, 1.0f), 0.1f, 100.0f);
-	glm::mat4 view = camera.GetViewMatrix();
+	anim_shader.use();
 
-	anim_shader.setMat4("proj", proj);
-	anim_shader.setMat4("view", view);
+	// the dancer's palette, then the drawn crowd's, into one buffer; each draw then points at its own range
+	auto upload_start = std::chrono::steady_clock::now();
+	const std::vector<glm::mat4>& transforms = animator.GetBoneMatrices();
+	size_t drawn_crowd = g_draw_crowd ? crowd.Size() : 0;
+	palette_buffer.Upload({ transforms, drawn_crowd > 0 ? std::span<const glm::mat4>(crowd.Palettes()) : std::span<const glm::mat4>() });
+	float upload_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - upload_start).count();
+	g_upload_ms = g_upload_ms * 0.95f + upload_ms * 0.05f;
 
-	auto& transforms = animator.GetBoneMatrices();
-
-	for (int i = 0; i < transforms.size(); ++i) {
-		anim_shader.setMat4("bone_matrices_arr[" + std::to_string(i) + "]", transforms[i]);
-	}
+	auto draw_character = [&](size_t character, const glm::mat4& model_mat) {
+		palette_buffer.Bind(character, offset_uniform);
+		model_uniform.set(model_mat);
+		model->Draw(anim_shader, LodView{ .model = model_mat, .camera_pos = camera.pos,
+			.fovy = glm::radians(camera.Zoom), .viewport_height = static_cast<float>(scr_height) });
+	};
 
 	glm::mat4 model_mat = glm::mat4(1.0f);
 	model_mat = glm::translate(model_mat, glm::vec3(0.2f, -1.0f, 0.0f));
 	model_mat = glm::scale(model_mat, glm::vec3(1.5f));
-	anim_shader.setMat4("model", model_mat);
-	model.Draw(anim_shader);
+	draw_character(0, model_mat);
+
+	// rows of kCrowdRow behind the dancer
+	constexpr int kCrowdRow = 25;
+	for (size_t i = 0; i < drawn_crowd; ++i) {
+		float x = (static_cast<int>(i % kCrowdRow) - kCrowdRow / 2) * 1.5f;
+		float z = -2.0f - static_cast<int>(i / kCrowdRow) * 1.5f;
+		draw_character(i + 1, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(x, -1.0f, z)), glm::vec3(1.5f)));
+	}
+}
+
+void LoadAssets()
+{
+	model = Model::LoadAsync(VAMPIRE_PATH, ModelLoadOptions{
+		.format			= VertexFormat::ePacked,
+		.shared_arena	= true,
+		.optimize		= true,
+		.lods			= true,
+		.texture_arrays	= true,
+		.residency		= MeshResidency::eSkinning });
+	// the animation reads the model's bone info, so it waits for the import to finish. The wait runs
+	// other pool tasks meanwhile, see ThreadPool::Wait
+	anim_loading = ThreadPool::Global().Submit([] {
+		model->WaitImported();
+		return std::make_unique<Animation>(VAMPIRE_PATH, model.get());
+	});
 }
 
 void RenderGUI() {
@@ -108,6 +230,21 @@ void RenderGUI() {
 			ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoNav);
 		ImGui::Text("speed"); ImGui::SameLine();
 		ImGui::SliderFloat("   ", &g_anim_speed, 0.05f, 5.0f);
+		ImGui::Text("palette upload %.4f ms (%s)", g_upload_ms, BonePaletteBuffer::StorageSupported() ? "storage buffer" : "uniform buffer");
+		ImGui::Checkbox("simd pose sampling", &g_simd_pose);
+		ImGui::Text("pose update %.4f ms", g_pose_ms);
+		if (anim) {
+			const ClipStats& clip = anim->GetClipStats();
+			ImGui::Text("clip %.1f KB (%.1fx), max error %.1e / %.1e rad", clip.bytes / 1024.0f, clip.Ratio(), clip.max_position_error, clip.max_rotation_error);
+		}
+		ImGui::Checkbox("cpu skinning", &g_cpu_skinning);
+		if (g_cpu_skinning)
+			ImGui::Text("cpu skinning %.4f ms (%.1f M vertices/s)", g_skin_ms, g_skin_ms > 0.0f ? g_skinned_vertices / (g_skin_ms * 1000.0f) : 0.0f);
+		ImGui::SliderInt("crowd size", &g_crowd_size, 0, 2000);
+		ImGui::SliderInt("crowd threads", &g_crowd_threads, 0, static_cast<int>(ThreadPool::Global().WorkerCount()) + 1);
+		ImGui::Text("crowd update %.4f ms (%.1f us per character)", g_crowd_ms, crowd.Size() ? g_crowd_ms * 1000.0f / crowd.Size() : 0.0f);
+		ImGui::Checkbox("draw crowd", &g_draw_crowd);
+		ImGui::Text("GL state calls: %llu issued, %llu skipped", (unsigned long long)GLState::LastFrame().issued, (unsigned long long)GLState::LastFrame().skipped);
 		ImGui::End();
 		ImGui::Render();
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -0,0 +1,80 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "alloc_tracker.h"
+#include "model.h"
+
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+// Loads a model twice, a cold import after dropping its mesh cache entry and a warm load from the
+// cache it left, with the counters of alloc_tracker.h and fails when a load allocates more than the
+// budget, so import regressions show up in ctest.
+//
+// usage: alloc_check [model path] [max peak MB] [max allocations]
+
+#define DEFAULT_MODEL_PATH MODEL_PATH_DIR"/nanosuit/nanosuit_salsa_dance.fbx"
+
+constexpr int	 kSkipped		 = 77;
+constexpr double kMaxPeakMB		 = 64.0;	// above the heap in use before the load
+constexpr size_t kMaxAllocations = 200000;
+
+int main(int argc, char** argv)
+{
+	if constexpr (!AllocTracker::kEnabled) {
+		std::cout << "built without TRACK_ALLOCATIONS, nothing to check\n";
+		return kSkipped;
+	}
+
+	std::string path		= argc > 1 ? argv[1] : DEFAULT_MODEL_PATH;
+	double		max_peak_mb = argc > 2 ? std::atof(argv[2]) : kMaxPeakMB;
+	size_t		max_count	= argc > 3 ? std::strtoull(argv[3], nullptr, 10) : kMaxAllocations;
+
+	// meshes and textures are uploaded while loading, so a (hidden) context is needed
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "alloc_check", nullptr, nullptr);
+	if (!window) {
+		std::cout << "no GL context, nothing to check\n";
+		glfwTerminate();
+		return kSkipped;
+	}
+	glfwMakeContextCurrent(window);
+	gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+
+	// an entry left by an earlier run would make the first pass warm as well
+	std::error_code ec;
+	std::filesystem::remove(MeshCache::CachePath(Model::CacheKey(path, {})), ec);
+
+	bool passed = true;
+	for (const char* pass : { "cold", "warm" }) {
+		size_t count = 0, peak = 0;
+		{
+			// the model's own load scope nests inside this one and has ended by the time it is read
+			AllocScope allocs;
+			Model model(path);
+			count = allocs.Count();
+			peak  = allocs.Peak();
+			if (model.meshes.empty()) {
+				std::cout << std::format("{} load of {} gave no meshes\n", pass, path);
+				passed = false;
+			}
+		}
+		double peak_mb = peak / (1024.0 * 1024.0);
+		bool   ok	   = peak_mb <= max_peak_mb && count <= max_count;
+		std::cout << std::format("{} load: {} allocations (max {}), peak {:.2f} MB (max {:.2f}) - {}\n",
+			pass, count, max_count, peak_mb, max_peak_mb, ok ? "ok" : "over budget");
+		passed = passed && ok;
+	}
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
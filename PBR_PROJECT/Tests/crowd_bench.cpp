@@ -0,0 +1,63 @@
+#include "animation_crowd.h"
+#include "synthetic_animation.h"
+#include "thread_pool.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <system_error>
+
+// AnimationCrowd::Update over a crowd of characters playing one clip with 1 to all threads of the
+// global pool, the time of one update and the speedup over a single thread. The clip is read without
+// its model, so no GL context is needed: its bones are numbered in channel order. When the file is
+// missing a synthetic skeleton of the given bone count plays instead.
+//
+// usage: crowd_bench [animation path] [characters] [updates] [synthetic bones]
+
+#define DEFAULT_ANIMATION_PATH MODEL_PATH_DIR"/vampire/dancing_vampire.dae"
+
+int main(int argc, char** argv)
+{
+	std::string path	   = argc > 1 ? argv[1] : DEFAULT_ANIMATION_PATH;
+	size_t		characters = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000;
+	int			updates	   = argc > 3 ? std::atoi(argv[3]) : 200;
+	int			bones	   = argc > 4 ? std::atoi(argv[4]) : 60;
+
+	Assimp::Importer		 importer;
+	const aiScene*			 scene = nullptr;
+	std::unique_ptr<aiScene> synthetic;
+	std::error_code			 ec;
+	if (std::filesystem::exists(path, ec))
+		scene = importer.ReadFile(path, aiProcess_Triangulate);
+	if (!scene || !scene->mRootNode || scene->mNumAnimations == 0) {
+		std::cout << std::format("no animation in {}, playing a synthetic skeleton of {} bones\n", path, bones);
+		synthetic = MakeSyntheticAnimation(bones, 900);
+		scene	  = synthetic.get();
+		path	  = "synthetic";
+	}
+	Animation animation(path, scene, {}, 0);
+	AnimationCrowd crowd;
+	for (size_t i = 0; i < characters; ++i)
+		crowd.Add(&animation, i * 7.3f, 0.8f + 0.04f * (i % 11));
+
+	size_t max_threads = ThreadPool::Global().WorkerCount() + 1;
+	std::cout << std::format("{}: {} characters, {} nodes, {} updates per thread count\n", path, characters, animation.GetNodes().size(), updates);
+	double single_ms = 0.0;
+	for (size_t threads = 1; threads <= max_threads; ++threads) {
+		crowd.Update(1.0f / 60.0f, threads);
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < updates; ++i)
+			crowd.Update(1.0f / 60.0f, threads);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / updates;
+		if (threads == 1) single_ms = ms;
+		std::cout << std::format("{:3} threads: {:8.3f} ms per update, {:5.2f}x\n", threads, ms, single_ms / ms);
+	}
+	return 0;
+}
@@ -0,0 +1,111 @@
+#include "animator.h"
+#include "synthetic_animation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <vector>
+
+// Animator::CalculateBoneTransforms over the flattened hierarchy against the recursive walk it replaced,
+// which looked every node up by name and copied the bone map per node. All three sample the same clip,
+// the baseline and the scalar pass track by track with AnimationClip::SampleTransform, so the first two
+// columns differ only by the walk.
+//
+// usage: hierarchy_bench [updates]
+
+class RecursiveWalk {
+public:
+	explicit RecursiveWalk(Animation* animation)
+		:
+		animation_(animation),
+		cursors_(animation->GetClip().TrackCount() * 3, 0),
+		bone_matrices_(Animator::kMaxBones, glm::mat4(1.0f)) {}
+
+	void CalculateBoneTransforms(float time) {
+		time_ = time;
+		CalculateBoneTransform(&animation_->GetRootNode(), glm::mat4(1.0f));
+	}
+
+	inline const std::vector<glm::mat4>& GetBoneMatrices() const { return bone_matrices_; }
+
+private:
+	void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parent_transform) {
+		std::string name = node->name;
+		glm::mat4   node_transform = node->transformation;
+
+		Bone* bone = animation_->FindBone(name);
+
+		if (bone) {
+			size_t track = bone - &animation_->GetBone(0);
+			node_transform = animation_->GetClip().SampleTransform(track, time_, &cursors_[track * 3]);
+		}
+
+		glm::mat4 glb_transform = parent_transform * node_transform;
+		auto bone_info_map = animation_->GetBoneIDMap();
+		if (auto iter = bone_info_map.find(name); iter != bone_info_map.end()) {
+			int idx = iter->second.id;
+			glm::mat4 offset = iter->second.offset;
+			bone_matrices_[idx] = glb_transform * offset;
+		}
+
+		for (int i = 0; i < node->children_count; ++i) {
+			CalculateBoneTransform(&node->children[i], glb_transform);
+		}
+	}
+
+	Animation*			   animation_;
+	std::vector<int>	   cursors_;
+	std::vector<glm::mat4> bone_matrices_;
+	float				   time_ = 0.0f;
+};
+
+template<class Update>
+static double MicrosecondsPerUpdate(int updates, float duration, Update&& update) {
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < updates; ++i) update(std::fmod(i * 0.5f, duration));
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / updates;
+}
+
+static float MaxDifference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b) {
+	float diff = 0.0f;
+	for (size_t m = 0; m < a.size(); ++m)
+		for (int c = 0; c < 4; ++c)
+			for (int r = 0; r < 4; ++r) diff = std::max(diff, std::abs(a[m][c][r] - b[m][c][r]));
+	return diff;
+}
+
+int main(int argc, char** argv)
+{
+	int updates = argc > 1 ? std::atoi(argv[1]) : 20000;
+
+	std::cout << std::format("{} updates, us per update\n", updates);
+	std::cout << std::format("{:>6} {:>10} {:>10} {:>10} {:>12}\n", "bones", "recursive", "flat", "flat simd", "max diff");
+	for (int bones : { 20, 50, 100 }) {
+		auto	  scene = MakeSyntheticAnimation(bones, 300);
+		Animation animation("synthetic", scene.get(), {}, 0);
+		float	  duration = animation.GetDuration();
+
+		RecursiveWalk recursive(&animation);
+		Animator	  scalar(&animation), simd(&animation);
+		scalar.SetSimdSampling(false);
+		auto flat = [](Animator& animator) {
+			return [&animator](float time) {
+				animator.SetTime(time);
+				animator.CalculateBoneTransforms();
+			};
+		};
+
+		double recursive_us = MicrosecondsPerUpdate(updates, duration, [&](float time) { recursive.CalculateBoneTransforms(time); });
+		double scalar_us	= MicrosecondsPerUpdate(updates, duration, flat(scalar));
+		double simd_us		= MicrosecondsPerUpdate(updates, duration, flat(simd));
+
+		// all three stopped at the same time, their palettes should agree
+		float diff = std::max(MaxDifference(recursive.GetBoneMatrices(), scalar.GetBoneMatrices()),
+			MaxDifference(recursive.GetBoneMatrices(), simd.GetBoneMatrices()));
+		std::cout << std::format("{:>6} {:10.2f} {:10.2f} {:10.2f} {:12.2e}\n", bones, recursive_us, scalar_us, simd_us, diff);
+	}
+	return 0;
+}
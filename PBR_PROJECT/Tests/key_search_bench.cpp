@@ -0,0 +1,75 @@
+#include "bone.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Bone::GetIdxFromVector against a linear scan from the first key and a plain binary search, on tracks
+// of 10 to 100k keys. Playback advances a fraction of a key per lookup, as an animator at a higher
+// frame rate than the clip does; seek looks up random times.
+//
+// usage: key_search_bench [lookups]
+
+static int LinearSearch(float time, const std::vector<KeyPosition>& keys) {
+	int last = static_cast<int>(keys.size()) - 2;
+	for (int i = 0; i < last; ++i) {
+		if (time < keys[i + 1].timestamp) return i;
+	}
+	return last;
+}
+
+static int BinarySearch(float time, const std::vector<KeyPosition>& keys) {
+	auto next = std::upper_bound(keys.begin() + 1, keys.end() - 1, time,
+		[](float t, const KeyPosition& key) { return t < key.timestamp; });
+	return static_cast<int>(next - keys.begin()) - 1;
+}
+
+template<class Search>
+static double NanosecondsPerLookup(const std::vector<float>& times, Search&& search, long long& checksum) {
+	auto start = std::chrono::steady_clock::now();
+	for (float time : times) checksum += search(time);
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / times.size();
+}
+
+int main(int argc, char** argv)
+{
+	size_t lookups = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+
+	std::mt19937 rng(1);
+	long long checksum = 0;
+	std::cout << std::format("{} lookups, ns per lookup\n", lookups);
+	std::cout << std::format("{:>7} {:>8} {:>10} {:>10} {:>10}\n", "keys", "access", "cursor", "linear", "binary");
+	for (int key_count : { 10, 100, 1000, 10000, 100000 }) {
+		std::vector<KeyPosition> keys(key_count);
+		for (int i = 0; i < key_count; ++i) keys[i] = { glm::vec3(0.0f), static_cast<float>(i) };
+		float duration = keys.back().timestamp;
+
+		std::vector<float> playback(lookups), seek(lookups);
+		float step = 0.3f;
+		for (size_t i = 0; i < lookups; ++i) playback[i] = std::fmod(i * step, duration);
+		std::uniform_real_distribution<float> any_time(0.0f, duration);
+		for (float& time : seek) time = any_time(rng);
+
+		for (auto [access, times] : { std::pair{ "playback", &playback }, std::pair{ "seek", &seek } }) {
+			// the linear scan is quadratic over a whole pass of a long track, so it gets every stride-th time
+			size_t stride = std::max<size_t>(1, lookups / (100000000 / key_count + 1));
+			std::vector<float> linear_times;
+			for (size_t i = 0; i < lookups; i += stride) linear_times.push_back((*times)[i]);
+			int cursor = 0;
+			double cursor_ns = NanosecondsPerLookup(*times,
+				[&](float t) { return Bone::GetIdxFromVector(t, keys, cursor); }, checksum);
+			double linear_ns = NanosecondsPerLookup(linear_times,
+				[&](float t) { return LinearSearch(t, keys); }, checksum);
+			double binary_ns = NanosecondsPerLookup(*times,
+				[&](float t) { return BinarySearch(t, keys); }, checksum);
+			std::cout << std::format("{:>7} {:>8} {:10.2f} {:10.2f} {:10.2f}\n", key_count, access, cursor_ns, linear_ns, binary_ns);
+		}
+	}
+	// keeps the lookups from being optimized away
+	std::cout << std::format("checksum {}\n", checksum);
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include "animation_clip.h"
+#include "bone.h"
+#include "synthetic_animation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Samples a synthetic clip through Bone::Update, as imported, and through PoseSampler and
+// AnimationClip::SampleTransform of a clip keeping every key, and fails when a local transform differs
+// by more than kMaxDifference in any element. What is left is the 16-bit rotation quantization and
+// nlerp against slerp between close keys. Times play forward a fraction of a key per sample, then seek
+// at random, so the cursors of both sides are exercised.
+//
+// usage: pose_sampler_check [bones] [keys]
+
+constexpr float kMaxDifference = 1e-3f;
+
+static float MaxDifference(const glm::mat4& a, const glm::mat4& b) {
+	float diff = 0.0f;
+	for (int c = 0; c < 4; ++c)
+		for (int r = 0; r < 4; ++r) diff = std::max(diff, std::abs(a[c][r] - b[c][r]));
+	return diff;
+}
+
+int main(int argc, char** argv)
+{
+	int bone_count = argc > 1 ? std::atoi(argv[1]) : 37;
+	int key_count  = argc > 2 ? std::atoi(argv[2]) : 200;
+
+	auto			   scene	 = MakeSyntheticAnimation(bone_count, key_count);
+	const aiAnimation* animation = scene->mAnimations[0];
+	std::vector<Bone>  bones;
+	for (unsigned i = 0; i < animation->mNumChannels; ++i) {
+		const aiNodeAnim* channel = animation->mChannels[i];
+		bones.push_back(Bone(channel->mNodeName.data, static_cast<int>(i), channel));
+	}
+	AnimationClip clip(bones, ClipCompression{ 0.0f, 0.0f, 0.0f });
+
+	float duration = static_cast<float>(animation->mDuration);
+	std::vector<float> times;
+	for (float time = 0.0f; time <= duration; time += 0.37f) times.push_back(time);
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> any_time(0.0f, duration);
+	for (int i = 0; i < 500; ++i) times.push_back(any_time(rng));
+
+	PoseSampler			   sampler;
+	std::vector<glm::mat4> pose(bones.size());
+	std::vector<int>	   cursors(bones.size() * 3, 0);
+	float sampler_diff = 0.0f, scalar_diff = 0.0f;
+	for (float time : times) {
+		sampler.Sample(clip, time, pose);
+		for (size_t b = 0; b < bones.size(); ++b) {
+			bones[b].Update(time);
+			glm::mat4 expected = bones[b].GetLocalTransform();
+			sampler_diff = std::max(sampler_diff, MaxDifference(expected, pose[b]));
+			scalar_diff	 = std::max(scalar_diff, MaxDifference(expected, clip.SampleTransform(b, time, &cursors[b * 3])));
+		}
+	}
+
+	bool passed = sampler_diff <= kMaxDifference && scalar_diff <= kMaxDifference;
+	std::cout << std::format("{} bones, {} samples: max difference PoseSampler {:.2e}, SampleTransform {:.2e} (max {:.2e}) - {}\n",
+		bones.size(), times.size(), sampler_diff, scalar_diff, kMaxDifference, passed ? "ok" : "failed");
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
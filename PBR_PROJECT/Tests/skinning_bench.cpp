@@ -0,0 +1,41 @@
+#include "cpu_skinning.h"
+#include "synthetic_skin.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <vector>
+
+// vertices per second of CpuSkinning::SkinReference and of CpuSkinning::Skin for 1 to all threads of
+// the global pool, on the vertices and palette skinning_check validates
+//
+// usage: skinning_bench [vertices] [repeats]
+
+int main(int argc, char** argv)
+{
+	size_t vertex_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+	int	   repeats		= argc > 2 ? std::atoi(argv[2]) : 20;
+
+	std::vector<glm::mat4>		palette	 = MakeSyntheticPalette();
+	std::vector<Vertex>			vertices = MakeSyntheticSkin(vertex_count);
+	std::vector<SkinningVertex> prepared = CpuSkinning::Prepare(vertices);
+	std::vector<glm::vec3>		positions(vertex_count), normals(vertex_count);
+
+	auto vertices_per_second = [&](auto&& skin) {
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeats; ++r) skin();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return vertex_count * repeats / seconds;
+	};
+	std::cout << std::format("{} vertices, {} repeats\n", vertex_count, repeats);
+	double reference = vertices_per_second([&] { CpuSkinning::SkinReference(vertices, palette, positions, normals); });
+	std::cout << std::format("reference: {:8.1f} M vertices/s\n", reference / 1e6);
+	size_t max_threads = ThreadPool::Global().WorkerCount() + 1;
+	for (size_t threads = 1; threads <= max_threads; ++threads) {
+		double rate = vertices_per_second([&] { CpuSkinning::Skin(prepared, palette, positions, normals, threads); });
+		std::cout << std::format("{:3} threads: {:8.1f} M vertices/s, {:5.2f}x the reference\n", threads, rate / 1e6, rate / reference);
+	}
+	return 0;
+}
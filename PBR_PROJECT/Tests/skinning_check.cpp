@@ -0,0 +1,51 @@
+#include "cpu_skinning.h"
+#include "synthetic_skin.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <vector>
+
+// CpuSkinning::Skin, on the SIMD path the build targets, against SkinReference on random vertices and
+// a random palette; fails when a position or normal differs by more than kMaxError relative to its
+// length. skinning_bench times the two.
+//
+// usage: skinning_check [vertices]
+
+constexpr float kMaxError = 1e-4f;
+
+#if defined(SIMD_FLOAT_AVX)
+constexpr const char* kPath = "AVX";
+#elif defined(SIMD_FLOAT_SSE)
+constexpr const char* kPath = "SSE";
+#else
+constexpr const char* kPath = "scalar";
+#endif
+
+static float RelativeError(const glm::vec3& value, const glm::vec3& expected) {
+	return glm::length(value - expected) / std::max(1.0f, glm::length(expected));
+}
+
+int main(int argc, char** argv)
+{
+	size_t vertex_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+
+	std::vector<glm::mat4> palette	= MakeSyntheticPalette();
+	std::vector<Vertex>	   vertices = MakeSyntheticSkin(vertex_count);
+
+	std::vector<SkinningVertex> prepared = CpuSkinning::Prepare(vertices);
+	std::vector<glm::vec3> positions(vertex_count), normals(vertex_count), ref_positions(vertex_count), ref_normals(vertex_count);
+	CpuSkinning::Skin(prepared, palette, positions, normals);
+	CpuSkinning::SkinReference(vertices, palette, ref_positions, ref_normals);
+
+	float pos_error = 0.0f, norm_error = 0.0f;
+	for (size_t v = 0; v < vertex_count; ++v) {
+		pos_error  = std::max(pos_error, RelativeError(positions[v], ref_positions[v]));
+		norm_error = std::max(norm_error, RelativeError(normals[v], ref_normals[v]));
+	}
+	bool passed = pos_error <= kMaxError && norm_error <= kMaxError;
+	std::cout << std::format("{} path, {} vertices: max error position {:.2e} normal {:.2e} (max {:.2e}) - {}\n",
+		kPath, vertex_count, pos_error, norm_error, kMaxError, passed ? "ok" : "failed");
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,76 @@
+#ifndef __SYNTHETIC_ANIMATION_H
+#define __SYNTHETIC_ANIMATION_H
+
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// An animated skeleton built in memory, so the checks and benchmarks run without asset files. Node i
+// is the child of node (i - 1) / 2 and is animated by channel i with key_count keys per track on whole
+// ticks: a few sines per bone, every fifth bone only rotates. The scene owns everything it points to,
+// as one returned by Assimp::Importer does
+inline std::unique_ptr<aiScene> MakeSyntheticAnimation(int bone_count, int key_count, unsigned seed = 1)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::vector<aiNode*> nodes(bone_count);
+	for (int i = 0; i < bone_count; ++i) {
+		nodes[i] = new aiNode();
+		nodes[i]->mName.Set("bone_" + std::to_string(i));
+	}
+	for (int i = 0; i < bone_count; ++i) {
+		int first = 2 * i + 1, count = std::max(0, std::min(bone_count - first, 2));
+		if (count == 0) continue;
+		nodes[i]->mNumChildren = count;
+		nodes[i]->mChildren	   = new aiNode*[count];
+		for (int c = 0; c < count; ++c) {
+			nodes[i]->mChildren[c] = nodes[first + c];
+			nodes[first + c]->mParent = nodes[i];
+		}
+	}
+
+	aiAnimation* animation = new aiAnimation();
+	animation->mDuration	   = key_count - 1;
+	animation->mTicksPerSecond = 30.0;
+	animation->mNumChannels	   = bone_count;
+	animation->mChannels	   = new aiNodeAnim*[bone_count];
+	for (int b = 0; b < bone_count; ++b) {
+		aiNodeAnim* channel = animation->mChannels[b] = new aiNodeAnim();
+		channel->mNodeName		  = nodes[b]->mName;
+		channel->mNumPositionKeys = channel->mNumRotationKeys = channel->mNumScalingKeys = key_count;
+		channel->mPositionKeys	  = new aiVectorKey[key_count];
+		channel->mRotationKeys	  = new aiQuatKey[key_count];
+		channel->mScalingKeys	  = new aiVectorKey[key_count];
+
+		float amplitude = b % 5 == 0 ? 0.0f : 0.5f * unit(rng);
+		float f1 = 2.0f * unit(rng), f2 = 3.0f * unit(rng);
+		float ax = unit(rng), ay = unit(rng), az = unit(rng);
+		float len = std::sqrt(ax * ax + ay * ay + az * az);
+		ax /= len; ay /= len; az /= len;
+		for (int k = 0; k < key_count; ++k) {
+			float s		= k / 30.0f;
+			float angle = 0.8f * std::sin(f2 * s) + 0.3f * std::sin(5.0f * s);
+			float sine	= std::sin(angle * 0.5f);
+			channel->mPositionKeys[k].mTime	 = k;
+			channel->mPositionKeys[k].mValue = aiVector3D(amplitude * std::sin(f1 * s), 1.0f + amplitude * std::cos(f2 * s), 0.0f);
+			channel->mRotationKeys[k].mTime	 = k;
+			channel->mRotationKeys[k].mValue = aiQuaternion(std::cos(angle * 0.5f), ax * sine, ay * sine, az * sine);
+			channel->mScalingKeys[k].mTime	 = k;
+			channel->mScalingKeys[k].mValue	 = aiVector3D(1.0f, 1.0f, 1.0f);
+		}
+	}
+
+	std::unique_ptr<aiScene> scene(new aiScene());
+	scene->mRootNode	  = nodes[0];
+	scene->mNumAnimations = 1;
+	scene->mAnimations	  = new aiAnimation*[1]{ animation };
+	return scene;
+}
+
+#endif // !__SYNTHETIC_ANIMATION_H
@@ -0,0 +1,57 @@
+#ifndef __SYNTHETIC_SKIN_H
+#define __SYNTHETIC_SKIN_H
+
+#include "vertex_format.h"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include <random>
+#include <vector>
+
+// what an Animator palette holds, Animator::kMaxBones
+constexpr size_t kSyntheticPaletteSize = 100;
+
+// bone matrices of random rotations, translations within 5 units and scales close to 1
+inline std::vector<glm::mat4> MakeSyntheticPalette(unsigned seed = 1)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f), positive(0.05f, 1.0f);
+	std::vector<glm::mat4> palette(kSyntheticPaletteSize);
+	for (glm::mat4& matrix : palette) {
+		glm::quat rotation = glm::normalize(glm::quat(unit(rng), unit(rng), unit(rng), unit(rng)));
+		glm::vec3 translation(5.0f * unit(rng), 5.0f * unit(rng), 5.0f * unit(rng));
+		matrix = glm::scale(glm::translate(glm::mat4(1.0f), translation) * glm::toMat4(rotation), glm::vec3(0.9f + 0.2f * positive(rng)));
+	}
+	return palette;
+}
+
+// vertices with one to four influences whose weights sum to one. Every 997th vertex names a bone past
+// the palette, which CpuSkinning leaves in bind pose
+inline std::vector<Vertex> MakeSyntheticSkin(size_t vertex_count, unsigned seed = 1)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f), positive(0.05f, 1.0f);
+	std::uniform_int_distribution<int> bone(0, static_cast<int>(kSyntheticPaletteSize) - 1), influences(1, MAX_BONE_INFLUENCE);
+	std::vector<Vertex> vertices(vertex_count);
+	for (size_t v = 0; v < vertex_count; ++v) {
+		Vertex& vertex = vertices[v];
+		vertex = {};
+		vertex.pos	= glm::vec3(unit(rng), unit(rng), unit(rng)) * 2.0f;
+		vertex.norm = glm::normalize(glm::vec3(unit(rng), unit(rng), positive(rng)));
+		int count = influences(rng);
+		float total = 0.0f;
+		for (int i = 0; i < MAX_BONE_INFLUENCE; ++i) {
+			vertex.m_BoneIDs[i] = i < count ? bone(rng) : -1;
+			vertex.m_Weights[i] = i < count ? positive(rng) : 0.0f;
+			total += vertex.m_Weights[i];
+		}
+		for (int i = 0; i < count; ++i) vertex.m_Weights[i] /= total;
+		if (v % 997 == 0) vertex.m_BoneIDs[0] = static_cast<int>(kSyntheticPaletteSize) + 3;
+	}
+	return vertices;
+}
+
+#endif // !__SYNTHETIC_SKIN_H